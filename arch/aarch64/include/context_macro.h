@@ -14,6 +14,22 @@
 #ifndef __CONTEXT_MACRO_H_
 #define __CONTEXT_MACRO_H_
 
+/*
+ * thread switch requested in interrupt, one slot for each cpu:
+ * flag, from thread sp pointer, to thread sp pointer
+ */
+#define SWITCH_SLOT_FLAG 		0x00
+#define SWITCH_SLOT_FROM 		0x08
+#define SWITCH_SLOT_TO 			0x10
+#define SWITCH_SLOT_SHIFT 		5
+
+.macro switch_slot reg, tmp
+	mrs 	\tmp, mpidr_el1
+	and 	\tmp, \tmp, #0xff
+	adr 	\reg, thread_switch_interrupt_flag
+	add 	\reg, \reg, \tmp, lsl #SWITCH_SLOT_SHIFT
+	.endm
+
 
 .macro save_context
 	/* Switch to use the EL0 stack pointer */
@@ -78,6 +94,125 @@
 	msr 	spsel, #1
 	.endm
 
+/*
+ * irq frame has the same layout as save_context, but only the registers
+ * a C function may clobber are saved: x0-x18, x29, x30, ELR and SPSR.
+ * x19-x28 are preserved by the handlers and written into the frame by
+ * save_callee_context only if a thread switch follows
+ */
+.macro save_caller_context
+	/* Switch to use the EL0 stack pointer */
+	msr 	spsel, #0
+
+	sub 	sp, sp, #0x110
+	stp 	x0, x1, [sp, #0x100]
+	stp 	x2, x3, [sp, #0xf0]
+	stp 	x4, x5, [sp, #0xe0]
+	stp 	x6, x7, [sp, #0xd0]
+	stp 	x8, x9, [sp, #0xc0]
+	stp 	x10, x11, [sp, #0xb0]
+	stp 	x12, x13, [sp, #0xa0]
+	stp 	x14, x15, [sp, #0x90]
+	stp 	x16, x17, [sp, #0x80]
+	str 	x18, [sp, #0x70]
+	str 	x29, [sp, #0x28]
+	stp 	x30, xzr, [sp, #0x10]
+
+	mrs 	x3, spsr_el1			/* save PSTATE (progream  status  register) */
+	mrs 	x2, elr_el1				/* save PC */
+	stp 	x2, x3, [sp]			/* save PSTATE and PC to sp stack */
+	mov 	x0, sp 					/* move sp into x0 for saving */
+
+	/* Switch to use the ELx stack pointer */
+	msr 	spsel, #1
+	.endm
+
+/*
+ * complete the irq frame pointed by x0 to a full context
+ */
+.macro save_callee_context
+	str 	x19, [x0, #0x78]
+	stp 	x20, x21, [x0, #0x60]
+	stp 	x22, x23, [x0, #0x50]
+	stp 	x24, x25, [x0, #0x40]
+	stp 	x26, x27, [x0, #0x30]
+	str 	x28, [x0, #0x20]
+	.endm
+
+.macro restore_caller_context
+	/* Swtich to use the EL0 stack pointer */
+	msr 	spsel, #0
+
+	/* Set the SP to pointer to the irq frame */
+	mov 	sp, x0
+	ldp 	x2, x3, [sp] 			/* SPSR and ELR */
+
+	msr 	spsr_el1, x3			/* set PSTATE (program status register) register */
+	msr 	elr_el1, x2				/* set pc register */
+
+	ldr 	x30, [sp, #0x10]
+	ldr 	x29, [sp, #0x28]
+	ldr 	x18, [sp, #0x70]
+	ldp 	x16, x17, [sp, #0x80]
+	ldp 	x14, x15, [sp, #0x90]
+	ldp 	x12, x13, [sp, #0xa0]
+	ldp 	x10, x11, [sp, #0xb0]
+	ldp 	x8, x9, [sp, #0xc0]
+	ldp 	x6, x7, [sp, #0xd0]
+	ldp 	x4, x5, [sp, #0xe0]
+	ldp 	x2, x3, [sp, #0xf0]
+	ldp 	x0, x1, [sp, #0x100]
+	add 	sp, sp, #0x110
+
+	/* Switch to use the ELx stack pointer. */
+	msr 	spsel, #1
+	eret
+	.endm
+
+/*
+ * nested irq frame, taken while a handler runs on SP_EL1. the interrupted
+ * handler continues afterwards, so only caller-saved registers and the
+ * exception state are kept, and the frame stays on the irq stack
+ */
+.macro save_nested_context
+	sub 	sp, sp, #0xc0
+	stp 	x0, x1, [sp, #0x00]
+	stp 	x2, x3, [sp, #0x10]
+	stp 	x4, x5, [sp, #0x20]
+	stp 	x6, x7, [sp, #0x30]
+	stp 	x8, x9, [sp, #0x40]
+	stp 	x10, x11, [sp, #0x50]
+	stp 	x12, x13, [sp, #0x60]
+	stp 	x14, x15, [sp, #0x70]
+	stp 	x16, x17, [sp, #0x80]
+	stp 	x18, x29, [sp, #0x90]
+
+	mrs 	x0, elr_el1				/* save PC */
+	mrs 	x1, spsr_el1			/* save PSTATE */
+	stp 	x30, x0, [sp, #0xa0]
+	str 	x1, [sp, #0xb0]
+	.endm
+
+.macro restore_nested_context
+	ldp 	x30, x0, [sp, #0xa0]
+	ldr 	x1, [sp, #0xb0]
+	msr 	elr_el1, x0				/* set pc register */
+	msr 	spsr_el1, x1			/* set PSTATE register */
+
+	ldp 	x18, x29, [sp, #0x90]
+	ldp 	x16, x17, [sp, #0x80]
+	ldp 	x14, x15, [sp, #0x70]
+	ldp 	x12, x13, [sp, #0x60]
+	ldp 	x10, x11, [sp, #0x50]
+	ldp 	x8, x9, [sp, #0x40]
+	ldp 	x6, x7, [sp, #0x30]
+	ldp 	x4, x5, [sp, #0x20]
+	ldp 	x2, x3, [sp, #0x10]
+	ldp 	x0, x1, [sp, #0x00]
+	add 	sp, sp, #0xc0
+	eret
+	.endm
+
 .macro restore_context
 	/* Swtich to use the EL0 stack pointer */
 	msr 	spsel, #0
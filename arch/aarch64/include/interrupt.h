@@ -25,9 +25,25 @@ typedef void (*sk_isr_handler_t)(int vector, void *param);
 void sk_hw_interrupt_mask(int vector);
 void sk_hw_interrupt_umask(int vector);
 void sk_hw_interrupt_ack(int vector);
+void sk_hw_interrupt_set_pending(int vector);
+void sk_hw_interrupt_send_ipi(int vector, sk_uint32_t cpu_mask);
+void sk_hw_interrupt_set_priority(int vector, sk_uint8_t priority);
+sk_uint8_t sk_hw_interrupt_get_priority(int vector);
 sk_int32_t sk_hw_interrupt_get_irq(void);
 sk_isr_handler_t sk_hw_interrupt_install(int vector, sk_isr_handler_t handler, void *param);
+sk_err_t sk_hw_interrupt_install_shared(int vector, sk_isr_handler_t handler, void *param);
+sk_uint32_t sk_hw_interrupt_max(void);
+sk_err_t sk_hw_interrupt_install_threaded(int vector, sk_isr_handler_t handler,
+										  void *param, sk_uint8_t prio);
 void sk_hw_interrupt_init(void);
+void sk_hw_interrupt_cpu_init(void);
 sk_bool_t sk_is_in_interrupt();
 
+/*
+ * gicv3 backend, selected by SK_USING_GICV3
+ */
+sk_int32_t gicv3_dist_init(sk_uint64_t dist_base, sk_uint32_t irq_start);
+sk_int32_t gicv3_redist_init(sk_uint64_t redist_base);
+sk_int32_t gicv3_cpu_init(void);
+
 #endif
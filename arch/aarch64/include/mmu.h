@@ -50,11 +50,41 @@
 #define MMU_MAP_ERROR_NOPAGE 			-3
 #define MMU_MAP_ERROR_CONFLICT 			-4
 
-#define MEM_ATTR_MEMORY 		((0x1UL << 10) | (0x2UL << 8) | (0x0UL << 6) | (0x1UL << 2) | )
-#define MEM_ATTR_IO 			((0x1UL << 10) | (0x2UL << 8) | (0x0UL << 6) | (0x2UL << 2) | )
+/*
+ * memory attributes of mair_el1, index 0 is device and index 1 is normal
+ * write-back memory. exclusive load/store is only guaranteed on normal
+ * cacheable memory, atomics and spinlocks need the mmu to be enabled
+ */
+#define MMU_MAIR_DEVICE 		0x00		/* Device-nGnRnE */
+#define MMU_MAIR_NORMAL 		0xff		/* Normal, inner/outer write-back non-transient */
+#define MMU_MAIR_VALUE 			(MMU_MAIR_DEVICE | (MMU_MAIR_NORMAL << 8))
+
+/*
+ * tcr_el1: 39 bits va, the walk starts at level 1 with 4KB granule, table
+ * walks are inner shareable write-back, ttbr1 is not used. ips is set from
+ * the physical address range of the cpu
+ */
+#define MMU_TCR_T0SZ 			25
+#define MMU_TCR_VALUE 			(MMU_TCR_T0SZ | (1 << 8) | (1 << 10) | (3 << 12) | (1 << 23))
+
+/* level 1 table, each entry maps a 1GB block */
+#define MMU_L1_SHIFT 			30
+#define MMU_L1_ENTRIES 			(1 << (39 - MMU_L1_SHIFT))
+
+/* identity map of qemu virt: devices below 1GB, ram from 1GB */
+#define MMU_DEVICE_BLOCKS 		1
+#define MMU_MEMORY_BLOCKS 		3
+
+#ifndef __ASSEMBLY__
+/* block descriptor attributes: af, shareability, el1 read/write, mair index */
+#define MEM_ATTR_MEMORY 		((0x1UL << 10) | (0x3UL << 8) | (0x0UL << 6) | (0x1UL << 2) | 0x1UL)
+#define MEM_ATTR_IO 			((0x3UL << 53) | (0x1UL << 10) | (0x0UL << 6) | (0x0UL << 2) | 0x1UL)
 
 #define BUS_ADDRESS(phys)		(((phys) & ~0xC0000000) | 0xC0000000)
 
+extern unsigned long sk_mmu_table[MMU_L1_ENTRIES];
+
+void __asm_mmu_enable(unsigned long *table);
 void mmu_init(void);
 void mmu_enable(void);
 void armv8_map_large(unsigned long va, unsigned long pa, int count, unsigned long attr);
@@ -72,5 +102,7 @@ void hw_dcache_disable(void);
 void hw_icache_enable(void);
 void hw_icache_invalidate_all(void);
 void hw_icache_disable(void);
+#endif /* __ASSEMBLY__ */
+
 #endif
 
@@ -0,0 +1,379 @@
+/*
+ *  gicv3.c
+ *
+ *  brif
+ *      gicv3 interrupt controller, system register cpu interface
+ *
+ *  (C) 2025.04.20 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <base_def.h>
+#include <config.h>
+#include <interrupt.h>
+#include <armv8.h>
+#include <hw.h>
+
+#ifdef SK_USING_GICV3
+
+/* Macro to accress the generic interruot controller distributor */
+#define GICD_CTLR(hw_base)					__REG32((hw_base) + 0x0000U)
+#define GICD_TYPER(hw_base)					__REG32((hw_base) + 0x0004U)
+#define GICD_IGROUPR(hw_base, n)			__REG32((hw_base) + 0x0080U + ((n)/32U) * 4U)
+#define GICD_ISENABLER(hw_base, n)			__REG32((hw_base) + 0x0100U + ((n)/32U) * 4U)
+#define GICD_ICENABLER(hw_base, n)			__REG32((hw_base) + 0x0180U + ((n)/32U) * 4U)
+#define GICD_ISPENDR(hw_base, n)			__REG32((hw_base) + 0x0200U + ((n)/32U) * 4U)
+#define GICD_ICPENDR(hw_base, n)			__REG32((hw_base) + 0x0280U + ((n)/32U) * 4U)
+#define GICD_IPRIORITYR(hw_base, n)			__REG32((hw_base) + 0x0400U + ((n)/4U) * 4U)
+#define GICD_IPRIORITYR_BYTE(hw_base, n)	__REG8((hw_base) + 0x0400U + (n))
+#define GICD_ICFGR(hw_base, n)				__REG32((hw_base) + 0x0C00U + ((n)/16U) * 4U)
+#define GICD_IROUTER(hw_base, n)			__REG64((hw_base) + 0x6000U + (n) * 8U)
+
+#define GICD_CTLR_RWP						(1U << 31)
+#define GICD_CTLR_ARE						(1U << 4)
+#define GICD_CTLR_ENABLE_G1					(1U << 1)
+#define GICD_CTLR_ENABLE_G0					(1U << 0)
+
+/* Macro to accress the redistributor, RD_base frame */
+#define GICR_CTLR(hw_base)					__REG32((hw_base) + 0x0000U)
+#define GICR_TYPER(hw_base)					__REG64((hw_base) + 0x0008U)
+#define GICR_WAKER(hw_base)					__REG32((hw_base) + 0x0014U)
+
+#define GICR_TYPER_LAST						(1U << 4)
+#define GICR_WAKER_PROCESSOR_SLEEP			(1U << 1)
+#define GICR_WAKER_CHILDREN_ASLEEP			(1U << 2)
+
+/* Macro to accress the redistributor, SGI_base frame for SGIs and PPIs */
+#define GICR_SGI_OFFSET						0x10000U
+#define GICR_IGROUPR0(hw_base)				__REG32((hw_base) + GICR_SGI_OFFSET + 0x0080U)
+#define GICR_ISENABLER0(hw_base)			__REG32((hw_base) + GICR_SGI_OFFSET + 0x0100U)
+#define GICR_ICENABLER0(hw_base)			__REG32((hw_base) + GICR_SGI_OFFSET + 0x0180U)
+#define GICR_ISPENDR0(hw_base)				__REG32((hw_base) + GICR_SGI_OFFSET + 0x0200U)
+#define GICR_ICPENDR0(hw_base)				__REG32((hw_base) + GICR_SGI_OFFSET + 0x0280U)
+#define GICR_IPRIORITYR(hw_base, n)			__REG32((hw_base) + GICR_SGI_OFFSET + 0x0400U + ((n)/4U) * 4U)
+#define GICR_IPRIORITYR_BYTE(hw_base, n)	__REG8((hw_base) + GICR_SGI_OFFSET + 0x0400U + (n))
+#define GICR_ICFGR1(hw_base)				__REG32((hw_base) + GICR_SGI_OFFSET + 0x0C04U)
+
+/* stride between the redistributors of two cpus */
+#define GICR_STRIDE							0x20000U
+
+/* SGIs and PPIs are banked in the redistributor */
+#define GIC_PRIVATE_IRQS					32
+
+struct gicv3_info
+{
+	sk_uint64_t offset;					/* the first interrupt index in the vector table */
+	sk_uint64_t dist_base;				/* the base address of the gic distributor */
+	sk_uint64_t redist_base[SK_CPUS_NR];	/* the redistributor of each cpu */
+};
+static struct gicv3_info gic_ctl;
+
+/*
+ * wait until the distributor has applied the register writes
+ */
+static void __gicv3_dist_wait_rwp(void)
+{
+	while(GICD_CTLR(gic_ctl.dist_base) & GICD_CTLR_RWP);
+}
+
+/*
+ * the redistributor of current cpu
+ */
+static sk_uint64_t __gicv3_redist(void)
+{
+	return gic_ctl.redist_base[hw_cpu_id()];
+}
+
+/*
+ * This function will mask a interrupt
+ * @param:
+ * 		vector: the interrupt number
+ */
+void sk_hw_interrupt_mask(int vector)
+{
+	sk_uint32_t mask = 1U << (vector % 32U);
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	if(irq < GIC_PRIVATE_IRQS)
+		GICR_ICENABLER0(__gicv3_redist()) = mask;
+	else
+		GICD_ICENABLER(gic_ctl.dist_base, irq) = mask;
+}
+
+/*
+ * This function will umask a interrupt
+ * @param:
+ * 		vector: the interrupt number
+ */
+void sk_hw_interrupt_umask(int vector)
+{
+	sk_uint32_t mask = 1U << (vector % 32U);
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	if(irq < GIC_PRIVATE_IRQS)
+		GICR_ISENABLER0(__gicv3_redist()) = mask;
+	else
+		GICD_ISENABLER(gic_ctl.dist_base, irq) = mask;
+}
+
+/*
+ * This function will return eth active interrupt number
+ * @param: none
+ */
+sk_int32_t sk_hw_interrupt_get_irq(void)
+{
+	sk_uint64_t irq;
+
+	__asm__ volatile ("mrs %0, ICC_IAR1_EL1" : "=r" (irq) :: "memory");
+
+	return (sk_int32_t)(irq & 0xFFFFFFU) + gic_ctl.offset;
+}
+
+/*
+ * This function acknowledges the interrupt
+ * @param:
+ * 		vector: the interrupt number
+ */
+void sk_hw_interrupt_ack(int vector)
+{
+	sk_uint32_t mask = 1U << (vector % 32U);
+	sk_uint64_t irq = (vector & SK_IRQ_ID_MASK) - gic_ctl.offset;
+
+	/* drop the software pended state of level interrupt, same as gicv2 */
+	if(irq < GIC_PRIVATE_IRQS)
+		GICR_ICPENDR0(__gicv3_redist()) = mask;
+	else
+		GICD_ICPENDR(gic_ctl.dist_base, irq) = mask;
+
+	__asm__ volatile ("msr ICC_EOIR1_EL1, %0" :: "r" (irq) : "memory");
+}
+
+/*
+ * This function will make a interrupt pending by software
+ * @param:
+ * 		vector: the interrupt number
+ */
+void sk_hw_interrupt_set_pending(int vector)
+{
+	sk_uint32_t mask = 1U << (vector % 32U);
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	if(irq < GIC_PRIVATE_IRQS)
+		GICR_ISPENDR0(__gicv3_redist()) = mask;
+	else
+		GICD_ISPENDR(gic_ctl.dist_base, irq) = mask;
+}
+
+/*
+ * This function will send a software generated interrupt to other cpus
+ * @param:
+ * 		vector: the sgi number, 0 ~ 15
+ * 		cpu_mask: bit n for cpu n, all the cpus are in affinity cluster 0
+ */
+void sk_hw_interrupt_send_ipi(int vector, sk_uint32_t cpu_mask)
+{
+	sk_uint64_t irq = vector - gic_ctl.offset;
+	sk_uint64_t val;
+
+	/* INTID [27:24], aff1 [23:16] is 0, target list of aff0 [15:0] */
+	val = ((irq & 0xFU) << 24U) | (cpu_mask & 0xFFFFU);
+
+	/* the sgi data must be visible before the target takes the interrupt */
+	__asm__ volatile ("dsb ishst" ::: "memory");
+	__asm__ volatile ("msr ICC_SGI1R_EL1, %0; isb" :: "r" (val) : "memory");
+}
+
+/*
+ * This function will set the priority of a interrupt, lower value is more
+ * urgent
+ * @param:
+ * 		vector: the interrupt number
+ * 		priority: the gic priority, 0x00 ~ 0xff
+ */
+void sk_hw_interrupt_set_priority(int vector, sk_uint8_t priority)
+{
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	if(irq < GIC_PRIVATE_IRQS)
+		GICR_IPRIORITYR_BYTE(__gicv3_redist(), irq) = priority;
+	else
+		GICD_IPRIORITYR_BYTE(gic_ctl.dist_base, irq) = priority;
+}
+
+/*
+ * This function will return the priority of a interrupt
+ * @param:
+ * 		vector: the interrupt number
+ */
+sk_uint8_t sk_hw_interrupt_get_priority(int vector)
+{
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	if(irq < GIC_PRIVATE_IRQS)
+		return GICR_IPRIORITYR_BYTE(__gicv3_redist(), irq);
+
+	return GICD_IPRIORITYR_BYTE(gic_ctl.dist_base, irq);
+}
+
+/*
+ * hw_interrupt_mask_kernel
+ * brief
+ * 		enter a kernel critical section by raising ICC_PMR_EL1 to
+ * 		SK_IRQ_KERNEL_PRIORITY, see the gicv2 version
+ * return
+ * 		the previous priority mask
+ */
+sk_base_t hw_interrupt_mask_kernel(void)
+{
+	sk_uint64_t level;
+	sk_uint64_t pmr = SK_IRQ_KERNEL_PRIORITY;
+
+	__asm__ volatile ("mrs %0, ICC_PMR_EL1" : "=r" (level));
+	if(level > SK_IRQ_KERNEL_PRIORITY)
+		__asm__ volatile ("msr ICC_PMR_EL1, %0; isb" :: "r" (pmr) : "memory");
+
+	return level;
+}
+
+/*
+ * hw_interrupt_unmask_kernel
+ * brief
+ * 		leave a kernel critical section entered by hw_interrupt_mask_kernel()
+ * param
+ * 		level: the priority mask returned by hw_interrupt_mask_kernel()
+ */
+void hw_interrupt_unmask_kernel(sk_base_t level)
+{
+	sk_uint64_t pmr = level;
+
+	__asm__ volatile ("dsb sy; msr ICC_PMR_EL1, %0" :: "r" (pmr) : "memory");
+}
+
+/*
+ * initialize the gic distributor, return the number of interrupts supported
+ */
+sk_int32_t gicv3_dist_init(sk_uint64_t dist_base, sk_uint32_t irq_start)
+{
+	sk_uint32_t gic_type, gic_max_irq, i;
+	sk_uint32_t pri = SK_IRQ_PRIORITY_DEFAULT;
+
+	gic_ctl.dist_base = dist_base;
+	gic_ctl.offset = irq_start;
+
+	/* Find out how many interrupts are supported */
+	gic_type = GICD_TYPER(dist_base);
+	gic_max_irq = ((gic_type & 0x1F) + 1) * 32;
+	if(gic_max_irq > 1020)
+		gic_max_irq = 1020;
+
+	pri |= pri << 8U;
+	pri |= pri << 16U;
+
+	GICD_CTLR(dist_base) = 0x0;
+	__gicv3_dist_wait_rwp();
+
+	/* SPIs only, SGIs and PPIs live in the redistributors */
+	for(i = GIC_PRIVATE_IRQS; i < gic_max_irq; i += 16)
+		GICD_ICFGR(dist_base, i) = 0x0;
+
+	for(i = GIC_PRIVATE_IRQS; i < gic_max_irq; i += 4)
+		GICD_IPRIORITYR(dist_base, i) = pri;
+
+	for(i = GIC_PRIVATE_IRQS; i < gic_max_irq; i += 32) {
+		GICD_ICENABLER(dist_base, i) = 0xffffffff;
+		GICD_IGROUPR(dist_base, i) = 0xffffffff;
+	}
+
+	/* enable affinity routing, then route all SPIs to cpu 0 */
+	GICD_CTLR(dist_base) = GICD_CTLR_ARE;
+	__gicv3_dist_wait_rwp();
+
+	for(i = GIC_PRIVATE_IRQS; i < gic_max_irq; i++)
+		GICD_IROUTER(dist_base, i) = 0x0;
+
+	/* all interrupts are group 1, taken as IRQ */
+	GICD_CTLR(dist_base) = GICD_CTLR_ARE | GICD_CTLR_ENABLE_G1 | GICD_CTLR_ENABLE_G0;
+	__gicv3_dist_wait_rwp();
+
+	return gic_max_irq;
+}
+
+/*
+ * find the redistributor of every cpu by its affinity and wake the current
+ * one up
+ */
+sk_int32_t gicv3_redist_init(sk_uint64_t redist_base)
+{
+	sk_uint64_t base, typer;
+	sk_uint32_t cpu, i, pri = SK_IRQ_PRIORITY_DEFAULT;
+
+	pri |= pri << 8U;
+	pri |= pri << 16U;
+
+	for(base = redist_base; ; base += GICR_STRIDE) {
+		typer = GICR_TYPER(base);
+		/* affinity value is aff3.aff2.aff1.aff0, aff0 is the cpu index */
+		cpu = (typer >> 32) & 0xFF;
+		if(cpu < SK_CPUS_NR)
+			gic_ctl.redist_base[cpu] = base;
+		if(typer & GICR_TYPER_LAST)
+			break;
+	}
+
+	base = __gicv3_redist();
+
+	/* wake up the redistributor */
+	GICR_WAKER(base) &= ~GICR_WAKER_PROCESSOR_SLEEP;
+	while(GICR_WAKER(base) & GICR_WAKER_CHILDREN_ASLEEP);
+
+	GICR_ICENABLER0(base) = 0xffffffff;
+	GICR_IGROUPR0(base) = 0xffffffff;
+	for(i = 0; i < GIC_PRIVATE_IRQS; i += 4)
+		GICR_IPRIORITYR(base, i) = pri;
+
+	/* PPIs level triggered */
+	GICR_ICFGR1(base) = 0x0;
+
+	return 0;
+}
+
+sk_int32_t gicv3_cpu_init(void)
+{
+	sk_uint64_t val;
+
+	/* use the system register interface */
+	__asm__ volatile ("mrs %0, ICC_SRE_EL1" : "=r" (val));
+	val |= 0x1;
+	__asm__ volatile ("msr ICC_SRE_EL1, %0; isb" :: "r" (val));
+
+	val = 0xF0;
+	__asm__ volatile ("msr ICC_PMR_EL1, %0" :: "r" (val));
+
+	/* same priority grouping as gicv2, see gic_cpu_init() */
+	val = 0x3;
+	__asm__ volatile ("msr ICC_BPR1_EL1, %0" :: "r" (val));
+
+	/* EOI drops priority and deactivates */
+	val = 0x0;
+	__asm__ volatile ("msr ICC_CTLR_EL1, %0" :: "r" (val));
+
+	/* Enable group 1 interrupt */
+	val = 0x1;
+	__asm__ volatile ("msr ICC_IGRPEN1_EL1, %0; isb" :: "r" (val));
+
+	return 0;
+}
+
+/*
+ * initialize the redistributor and the cpu interface of a secondary cpu,
+ * the distributor is shared and already set up
+ */
+void sk_hw_interrupt_cpu_init(void)
+{
+	gicv3_redist_init(GIC_REDIST_BASE);
+	gicv3_cpu_init();
+}
+
+#endif
@@ -15,6 +15,9 @@
 #include <interrupt.h>
 #include <armv8.h>
 #include <hw.h>
+#include <skernel.h>
+
+#ifndef SK_USING_GICV3
 
 /* Macro to accress the generic interrupt controller interface */
 #define GIC_CPU_CTRL(hw_base)				__REG32((hw_base) + 0x00U)
@@ -37,6 +40,7 @@
 #define GIC_DIST_ACTIVE_SET(hw_base, n)		__REG32((hw_base) + 0x300U + ((n)/32U) * 4U)
 #define GIC_DIST_ACTIVE_CLEAR(hw_base, n)	__REG32((hw_base) + 0x380U + ((n)/32U) * 4U)
 #define GIC_DIST_PRI(hw_base, n)			__REG32((hw_base) + 0x400U +  ((n)/4U) * 4U)
+#define GIC_DIST_PRI_BYTE(hw_base, n)		__REG8((hw_base) + 0x400U + (n))
 #define GIC_DIST_TARGET(hw_base, n)			__REG32((hw_base) + 0x800U +  ((n)/4U) * 4U)
 #define GIC_DIST_CONFIG(hw_base, n)			__REG32((hw_base) + 0xC00U + ((n)/16U) * 4U)
 #define GIC_DIST_SOFTINT(hw_base)			__REG32((hw_base) + 0xF00U)
@@ -52,8 +56,14 @@ struct gic_info
 };
 static struct gic_info gic_ctl;
 
-/* exception and interrupt handler table */
-struct sk_irq_desc isr_table[GIC_MAX_HANDLERS];
+#endif
+
+/*
+ * exception and interrupt handler table, sized by the number of interrupts
+ * the gic supports. the trap code indexes it by the acknowledged irq
+ */
+struct sk_irq_desc *isr_table;
+sk_uint32_t isr_table_size;
 
 const unsigned int vector_base = 0x00;
 
@@ -67,6 +77,245 @@ void sk_hw_vector_init(void)
 	set_current_vbar();
 }
 
+/*
+ * This function will return the number of interrupts, the valid vectors are
+ * 0 ~ sk_hw_interrupt_max() - 1
+ * @param: none
+ */
+sk_uint32_t sk_hw_interrupt_max(void)
+{
+	return isr_table_size;
+}
+
+/*
+ * This function will return the descriptor of a interrupt
+ * @param: 
+ * 		vector: the interrupt number
+ */
+struct sk_irq_desc *sk_hw_interrupt_get_desc(int vector)
+{
+	if(vector < 0 || vector >= isr_table_size)
+		return SK_NULL;
+
+	return &isr_table[vector];
+}
+
+/*
+ * __irq_desc_attach
+ * brief
+ * 		set up the per vector data when the first handler is installed
+ */
+static void __irq_desc_attach(struct sk_irq_desc *desc)
+{
+#ifdef SK_USING_IRQ_STAT
+	if(desc->stat == SK_NULL) {
+		desc->stat = (struct sk_irq_stat *)sk_malloc(sizeof(struct sk_irq_stat));
+		if(desc->stat)
+			sk_memset(desc->stat, 0, sizeof(struct sk_irq_stat));
+	}
+#endif
+}
+
+/*
+ * This function will install a interrupt service routine to a interrupt
+ * @param: 
+ * 		vector: the interrupt number
+ */
+sk_isr_handler_t sk_hw_interrupt_install(int vector, sk_isr_handler_t handler,
+								void *param)
+{
+	sk_isr_handler_t old_handler = SK_NULL;
+	struct sk_irq_desc *desc = sk_hw_interrupt_get_desc(vector);
+
+	if(desc) {
+		old_handler = desc->handler;
+
+		if(handler != SK_NULL) {
+			__irq_desc_attach(desc);
+			desc->flags &= ~SK_IRQ_FLAG_THREADED;
+			desc->handler = handler;
+			desc->param = param;
+		}
+	}
+
+	return old_handler;
+}
+
+/*
+ * This function will add a interrupt service routine to a shared interrupt.
+ * every handler of the line is called on each interrupt, so it must check
+ * whether its own device raised it
+ * @param: 
+ * 		vector: the interrupt number
+ * 		handler: the interrupt service routine
+ * 		param: parameter of handler
+ */
+sk_err_t sk_hw_interrupt_install_shared(int vector, sk_isr_handler_t handler,
+										void *param)
+{
+	struct sk_irq_desc *desc = sk_hw_interrupt_get_desc(vector);
+	struct sk_irq_action *action, **tail;
+	sk_base_t level;
+
+	if(desc == SK_NULL || handler == SK_NULL)
+		return SK_EINVAL;
+
+	/* an exclusive handler is installed */
+	if(desc->handler && !(desc->flags & SK_IRQ_FLAG_SHARED))
+		return SK_EBUSY;
+
+	if(desc->handler == SK_NULL) {
+		__irq_desc_attach(desc);
+		desc->flags |= SK_IRQ_FLAG_SHARED;
+		desc->handler = handler;
+		desc->param = param;
+		return SK_EOK;
+	}
+
+	action = (struct sk_irq_action *)sk_malloc(sizeof(struct sk_irq_action));
+	if(action == SK_NULL)
+		return SK_ENOMEM;
+
+	action->handler = handler;
+	action->param = param;
+	action->next = SK_NULL;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+	for(tail = &(desc->action); *tail; tail = &((*tail)->next));
+	*tail = action;
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	return SK_EOK;
+}
+
+#ifdef SK_USING_IRQ_STAT
+/*
+ * __irq_hist_bucket
+ * brief
+ * 		histogram bucket of a cycle count, log2 scale
+ */
+static sk_uint32_t __irq_hist_bucket(sk_uint64_t cycles)
+{
+	sk_uint32_t bucket = 0;
+
+	while(cycles > 1 && bucket < SK_IRQ_HIST_BUCKETS - 1) {
+		cycles >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+#endif
+
+/*
+ * sk_hw_interrupt_record_time
+ * brief
+ * 		account one handler run of a vector, called by the trap code. the
+ * 		time of nested handlers is included
+ * param
+ * 		vector: the interrupt number
+ * 		cycles: the handler time in counter cycles
+ */
+void sk_hw_interrupt_record_time(int vector, sk_uint64_t cycles)
+{
+#ifdef SK_USING_IRQ_STAT
+	struct sk_irq_desc *desc = sk_hw_interrupt_get_desc(vector);
+	struct sk_irq_stat *stat;
+
+	if(desc == SK_NULL || desc->stat == SK_NULL)
+		return;
+
+	stat = desc->stat;
+	stat->count++;
+	stat->cycles_total += cycles;
+	if(cycles > stat->cycles_max)
+		stat->cycles_max = cycles;
+	stat->cycles_hist[__irq_hist_bucket(cycles)]++;
+#endif
+}
+
+/*
+ * sk_hw_interrupt_record_latency
+ * brief
+ * 		account the entry latency of a vector. only the driver knows when its
+ * 		interrupt was raised, e.g. the timer compare value
+ * param
+ * 		vector: the interrupt number
+ * 		cycles: the delay from raising to handler entry in counter cycles
+ */
+void sk_hw_interrupt_record_latency(int vector, sk_uint64_t cycles)
+{
+#ifdef SK_USING_IRQ_STAT
+	struct sk_irq_desc *desc = sk_hw_interrupt_get_desc(vector);
+	struct sk_irq_stat *stat;
+
+	if(desc == SK_NULL || desc->stat == SK_NULL)
+		return;
+
+	stat = desc->stat;
+	if(cycles > stat->latency_max)
+		stat->latency_max = cycles;
+	stat->latency_hist[__irq_hist_bucket(cycles)]++;
+#endif
+}
+
+/*
+ * sk_hw_interrupt_get_stat
+ * brief
+ * 		copy the statistics of a vector
+ * param
+ * 		vector: the interrupt number
+ * 		stat: buffer of the statistics
+ */
+sk_err_t sk_hw_interrupt_get_stat(int vector, struct sk_irq_stat *stat)
+{
+#ifdef SK_USING_IRQ_STAT
+	struct sk_irq_desc *desc = sk_hw_interrupt_get_desc(vector);
+	sk_base_t level;
+
+	if(desc == SK_NULL || desc->stat == SK_NULL)
+		return SK_EINVAL;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+	*stat = *(desc->stat);
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	return SK_EOK;
+#else
+	return SK_ERROR;
+#endif
+}
+
+/*
+ * sk_hw_interrupt_clear_stat
+ * brief
+ * 		reset the statistics of a vector
+ * param
+ * 		vector: the interrupt number
+ */
+void sk_hw_interrupt_clear_stat(int vector)
+{
+#ifdef SK_USING_IRQ_STAT
+	struct sk_irq_desc *desc = sk_hw_interrupt_get_desc(vector);
+	sk_base_t level;
+
+	if(desc == SK_NULL || desc->stat == SK_NULL)
+		return;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+	sk_memset(desc->stat, 0, sizeof(struct sk_irq_stat));
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+#endif
+}
+
+#ifndef SK_USING_GICV3
+
 /*
  * This function will mask a interrupt 
  * @param: 
@@ -109,44 +358,123 @@ sk_int32_t sk_hw_interrupt_get_irq(void)
 /*
  * This function acknowledges the interrupt
  * @param: 
- * 		vector: the interrupt number
+ * 		vector: the interrupt number, or the value returned by
+ * 				sk_hw_interrupt_get_irq() with the source cpu of a sgi
  */
 void sk_hw_interrupt_ack(int vector)
+{
+	sk_uint64_t mask = 1U << ((vector & SK_IRQ_ID_MASK) % 32U);
+	sk_int32_t  irq = (vector & SK_IRQ_ID_MASK) - gic_ctl.offset;
+
+	GIC_DIST_PENDING_CLEAR(gic_ctl.dist_base, irq) = mask;
+	/* eoi of a sgi must match the source cpu it was acknowledged with */
+	GIC_CPU_EOI(gic_ctl.cpu_base) = vector - gic_ctl.offset;
+}
+
+
+/*
+ * This function will make a interrupt pending by software
+ * @param: 
+ * 		vector: the interrupt number
+ */
+void sk_hw_interrupt_set_pending(int vector)
 {
 	sk_uint64_t mask = 1U << (vector % 32U);
 	sk_int32_t  irq = vector - gic_ctl.offset;
 
-	GIC_DIST_PENDING_CLEAR(gic_ctl.dist_base, irq) = mask;
-	GIC_CPU_EOI(gic_ctl.cpu_base) = irq;
+	GIC_DIST_PENDING_SET(gic_ctl.dist_base, irq) = mask;
 }
 
+/*
+ * This function will send a software generated interrupt to other cpus
+ * @param: 
+ * 		vector: the sgi number, 0 ~ 15
+ * 		cpu_mask: bit n for cpu n
+ */
+void sk_hw_interrupt_send_ipi(int vector, sk_uint32_t cpu_mask)
+{
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	/* the sgi data must be visible before the target takes the interrupt */
+	__asm__ volatile ("dsb ishst" ::: "memory");
+
+	/* target list filter, cpu target list [23:16], sgi id [3:0] */
+	GIC_DIST_SOFTINT(gic_ctl.dist_base) = ((cpu_mask & 0xFFU) << 16U) | (irq & 0xFU);
+}
 
 /*
- * This function will install a interrupt service routine to a interrupt
+ * This function will set the priority of a interrupt, lower value is more
+ * urgent. with nesting enabled, a handler is preempted only by interrupts
+ * of a higher priority group
  * @param: 
  * 		vector: the interrupt number
+ * 		priority: the gic priority, 0x00 ~ 0xff
  */
-sk_isr_handler_t sk_hw_interrupt_install(int vector, sk_isr_handler_t handler,
-								void *param)
+void sk_hw_interrupt_set_priority(int vector, sk_uint8_t priority)
 {
-	sk_isr_handler_t old_handler = SK_NULL;
+	sk_int32_t  irq = vector - gic_ctl.offset;
 
-	if(vector < GIC_MAX_HANDLERS) {
-		old_handler = isr_table[vector].handler;
+	GIC_DIST_PRI_BYTE(gic_ctl.dist_base, irq) = priority;
+}
 
-		if(handler != SK_NULL) {
-			isr_table[vector].handler = handler;
-			isr_table[vector].param = param;
-		}
+/*
+ * This function will return the priority of a interrupt
+ * @param: 
+ * 		vector: the interrupt number
+ */
+sk_uint8_t sk_hw_interrupt_get_priority(int vector)
+{
+	sk_int32_t  irq = vector - gic_ctl.offset;
+
+	return GIC_DIST_PRI_BYTE(gic_ctl.dist_base, irq);
+}
+
+/*
+ * hw_interrupt_mask_kernel
+ * brief
+ * 		enter a kernel critical section by raising the gic priority mask to
+ * 		SK_IRQ_KERNEL_PRIORITY. interrupts more urgent than the threshold are
+ * 		still taken, so their handlers must not call any kernel api. the
+ * 		section must not switch thread, the mask belongs to the cpu
+ * return
+ * 		the previous priority mask
+ */
+sk_base_t hw_interrupt_mask_kernel(void)
+{
+	sk_base_t level;
+
+	level = GIC_CPU_PRIMASK(gic_ctl.cpu_base);
+	if(level > SK_IRQ_KERNEL_PRIORITY) {
+		GIC_CPU_PRIMASK(gic_ctl.cpu_base) = SK_IRQ_KERNEL_PRIORITY;
+		/* read back, the cpu interface has the new mask before we go on */
+		(void)GIC_CPU_PRIMASK(gic_ctl.cpu_base);
+		__asm__ volatile ("dsb sy; isb" ::: "memory");
 	}
 
-	return old_handler;
+	return level;
+}
+
+/*
+ * hw_interrupt_unmask_kernel
+ * brief
+ * 		leave a kernel critical section entered by hw_interrupt_mask_kernel()
+ * param
+ * 		level: the priority mask returned by hw_interrupt_mask_kernel()
+ */
+void hw_interrupt_unmask_kernel(sk_base_t level)
+{
+	__asm__ volatile ("dsb sy" ::: "memory");
+	GIC_CPU_PRIMASK(gic_ctl.cpu_base) = level;
 }
 
+/*
+ * initialize the gic distributor, return the number of interrupts supported
+ */
 sk_int32_t gic_dist_init(sk_uint64_t index, sk_uint64_t dist_base, sk_uint32_t irq_start)
 {
 	sk_uint32_t gic_type, gic_max_irq, i;
 	sk_uint64_t cpu_mask = 1U << 0U;
+	sk_uint32_t pri = SK_IRQ_PRIORITY_DEFAULT;
 
 	gic_ctl.dist_base = dist_base;
 	gic_ctl.offset = irq_start;
@@ -165,6 +493,9 @@ sk_int32_t gic_dist_init(sk_uint64_t index, sk_uint64_t dist_base, sk_uint32_t i
 	cpu_mask |= cpu_mask << 16U;
 	cpu_mask |= cpu_mask << 24U;
 
+	pri |= pri << 8U;
+	pri |= pri << 16U;
+
 	GIC_DIST_CTRL(dist_base) = 0x0;
 
 	/* set all global interrupts to be level triggered, active low */
@@ -179,7 +510,7 @@ sk_int32_t gic_dist_init(sk_uint64_t index, sk_uint64_t dist_base, sk_uint32_t i
 
 	/* set priority on all interrupts */
 	for(i  = 0; i < gic_max_irq; i += 4) {
-		GIC_DIST_PRI(dist_base, i) = 0xa0a0a0a0;
+		GIC_DIST_PRI(dist_base, i) = pri;
 	}
 	
 	/* disable all interrupts */
@@ -195,7 +526,7 @@ sk_int32_t gic_dist_init(sk_uint64_t index, sk_uint64_t dist_base, sk_uint32_t i
 	/* Enable group0 and group1 interrupt forwarding */
 	GIC_DIST_CTRL(dist_base) = 0x01;
 
-	return 0;
+	return gic_max_irq;
 }
 
 sk_int32_t gic_cpu_init(sk_uint64_t index, sk_uint64_t cpu_base)
@@ -203,7 +534,13 @@ sk_int32_t gic_cpu_init(sk_uint64_t index, sk_uint64_t cpu_base)
 	gic_ctl.cpu_base = cpu_base;
 
 	GIC_CPU_PRIMASK(cpu_base) = 0xF0;
-	GIC_CPU_BINPOINT(cpu_base) = 0x7;
+
+	/*
+	 * group priority is bits [7:4], an interrupt preempts the running one
+	 * only if its group priority is higher. subpriority [3:0] only orders
+	 * pending interrupts of the same group
+	 */
+	GIC_CPU_BINPOINT(cpu_base) = 0x3;
 
 	/* Enable CPU innterrupt */
 	GIC_CPU_CTRL(cpu_base) = 0x01;
@@ -211,7 +548,27 @@ sk_int32_t gic_cpu_init(sk_uint64_t index, sk_uint64_t cpu_base)
 	return 0;
 }
 
+/*
+ * initialize the banked sgis and ppis and the gic cpu interface of a
+ * secondary cpu, the distributor is shared and already set up
+ */
+void sk_hw_interrupt_cpu_init(void)
+{
+	sk_uint32_t i, pri = SK_IRQ_PRIORITY_DEFAULT;
+
+	pri |= pri << 8U;
+	pri |= pri << 16U;
 
+	for(i  = 0; i < 32; i += 4) {
+		GIC_DIST_PRI(gic_ctl.dist_base, i) = pri;
+	}
+	GIC_DIST_ENABLE_CLEAR(gic_ctl.dist_base, 0) = 0xffffffff;
+	GIC_DIST_IGROUP(gic_ctl.dist_base, 0) = 0x0;
+
+	gic_cpu_init(0, GIC_CPU_BASE);
+}
+
+#endif
 
 /*
  * This function will initialize hardware interrupt
@@ -221,11 +578,26 @@ void sk_hw_interrupt_init(void)
 	/* initialize vector table */
 	sk_hw_vector_init();
 
+	/* initialize gic distributor, it tells how many interrupts there are */
+#ifdef SK_USING_GICV3
+	isr_table_size = gicv3_dist_init(GIC_DIST_BASE, GIC_IRQ_START);
+#else
+	isr_table_size = gic_dist_init(0, GIC_DIST_BASE, GIC_IRQ_START);
+#endif
+
 	/* initialize exceptions table */
-	//memset(isr_table, 0x00, sizeof(isr_table));
-	
-	/* initialize gic */
-	gic_dist_init(0, GIC_DIST_BASE, GIC_IRQ_START);
+	isr_table = (struct sk_irq_desc *)sk_malloc(isr_table_size * sizeof(struct sk_irq_desc));
+	if(isr_table)
+		sk_memset(isr_table, 0x00, isr_table_size * sizeof(struct sk_irq_desc));
+	else
+		isr_table_size = 0;
+
+	/* initialize gic cpu interface */
+#ifdef SK_USING_GICV3
+	gicv3_redist_init(GIC_REDIST_BASE);
+	gicv3_cpu_init();
+#else
 	gic_cpu_init(0, GIC_CPU_BASE);
+#endif
 }
 
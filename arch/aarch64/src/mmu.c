@@ -0,0 +1,53 @@
+/*
+ *  mmu.c
+ *
+ *  brif
+ *      identity map and mmu enable
+ *
+ *  (C) 2025.04.30 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <base_def.h>
+#include <config.h>
+#include <mmu.h>
+
+/* level 1 translation table shared by all cpus, built once by the boot cpu */
+unsigned long sk_mmu_table[MMU_L1_ENTRIES] ALIGN(4096);
+
+/*
+ * mmu_init
+ * brief
+ * 		build the identity map with 1GB blocks: the device region is mapped
+ * 		Device-nGnRnE and never executed, the ram is mapped normal write-back
+ * 		inner shareable, so that exclusive load/store works on it
+ *
+ * note: called by the boot cpu with mmu off, before any lock is taken
+ */
+void mmu_init(void)
+{
+	unsigned long index;
+
+	for(index = 0; index < MMU_L1_ENTRIES; index++)
+		sk_mmu_table[index] = 0;
+
+	for(index = 0; index < MMU_DEVICE_BLOCKS; index++)
+		sk_mmu_table[index] = (index << MMU_L1_SHIFT) | MEM_ATTR_IO;
+
+	for(; index < MMU_DEVICE_BLOCKS + MMU_MEMORY_BLOCKS; index++)
+		sk_mmu_table[index] = (index << MMU_L1_SHIFT) | MEM_ATTR_MEMORY;
+}
+
+/*
+ * mmu_enable
+ * brief
+ * 		enable mmu and data cache of current cpu with the identity map.
+ * 		secondary cpus call __asm_mmu_enable directly from secondary_entry,
+ * 		before anything is written with mmu off
+ */
+void mmu_enable(void)
+{
+	__asm_mmu_enable(sk_mmu_table);
+}
@@ -14,6 +14,7 @@
 #include <armv8.h>
 #include <base_def.h>
 #include <hw.h>
+#include <config.h>
 
 /*
  * When comes across an instruction which it can't handle,
@@ -33,25 +34,61 @@ void sk_hw_trap_error(struct sk_hw_exp_stack *regs)
 
 void sk_hw_trap_irq(void)
 {
-	void *param;
-	sk_int32_t irq;
-	sk_isr_handler_t isr_func;
-	extern struct sk_irq_desc isr_table[];
+	sk_int32_t iar, irq;
+	struct sk_irq_desc *desc;
+	struct sk_irq_action *action;
+	extern struct sk_irq_desc *isr_table;
+	extern sk_uint32_t isr_table_size;
+#ifdef SK_USING_IRQ_STAT
+	sk_uint64_t start, end;
+#endif
 
-	/* get irq number */
-	irq = sk_hw_interrupt_get_irq();
+	/*
+	 * get irq number, the acknowledge value of a sgi also carries the
+	 * source cpu, it is given back as is at the end of interrupt
+	 */
+	iar = sk_hw_interrupt_get_irq();
+	irq = iar & SK_IRQ_ID_MASK;
 	if(irq == 1023)
 		return;
 
-	/* get interrupt service routine */
-	isr_func = isr_table[irq].handler;
-	if(isr_func) {
-		param = isr_table[irq].param;
-		isr_func(irq, param);
+	/* the table covers every interrupt the gic reports */
+	if(irq >= isr_table_size) {
+		sk_hw_interrupt_ack(iar);
+		return;
+	}
+
+	/* get interrupt descriptor */
+	desc = &isr_table[irq];
+	desc->count++;
+	if(desc->handler) {
+#ifdef SK_USING_IRQ_STAT
+		__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (start));
+#endif
+#ifdef SK_USING_IRQ_NESTING
+		/*
+		 * the acknowledge raised the gic running priority to this irq, so
+		 * only interrupts of a higher priority group are taken while the
+		 * handler runs. the nested irq is taken on SP_EL1 and never switches
+		 * thread, switching is left to the outermost level
+		 */
+		__asm__ volatile ("msr daifclr, #2" ::: "memory");
+#endif
+		desc->handler(irq, desc->param);
+		/* the other handlers of a shared line */
+		for(action = desc->action; action; action = action->next)
+			action->handler(irq, action->param);
+#ifdef SK_USING_IRQ_NESTING
+		__asm__ volatile ("msr daifset, #2" ::: "memory");
+#endif
+#ifdef SK_USING_IRQ_STAT
+		__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (end));
+		sk_hw_interrupt_record_time(irq, end - start);
+#endif
 	}
 
-	/* end of interrupt */
-	sk_hw_interrupt_ack(irq);
+	/* end of interrupt, drop the running priority */
+	sk_hw_interrupt_ack(iar);
 }
 
 void sk_hw_trap_fiq(void)
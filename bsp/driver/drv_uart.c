@@ -13,6 +13,7 @@
 #include <serial.h>
 #include <config.h>
 #include <interrupt.h>
+#include <workqueue.h>
 
 struct sk_uart_device
 {
@@ -112,7 +113,9 @@ int sk_hw_uart_init()
 	/* register uart0 device */
 	sk_hw_serial_register(&__serial0, "uart0", 0, uart);
 
-	sk_hw_interrupt_install(uart->irq_num, sk_hw_uart_isr, &__serial0);
+	/* drain the fifo and wake up the reader in thread, not in hard irq */
+	sk_hw_interrupt_install_threaded(uart->irq_num, sk_hw_uart_isr, &__serial0,
+									 SK_WORK_PRIO_HIGH);
 	sk_hw_interrupt_umask(uart->irq_num);
 
 	return 0;
@@ -14,6 +14,8 @@
 #include <base_def.h>
 #include <kobj.h>
 #include <sched.h>
+#include <hw.h>
+#include <spinlock.h>
 
 static long clear()
 {
@@ -33,16 +35,17 @@ SHELL_CMD_EXPORT(version, show s-kernel version);
 static long top()
 {
 	struct sk_object_info *info;
-	sk_base_t level;
 	sk_list_t *entry;
 	struct sk_thread *thread;
-	sk_kprintf("thread   prio   status      sp     stack_size cpu_usage   remain_tick\n");
-	sk_kprintf("------   ---- ----------  ---------- ---------- ---------   -----------\n");
+	sk_kprintf("thread   prio cpu  status      sp     stack_size max_used cpu_usage   remain_tick\n");
+	sk_kprintf("------   ---- --- ----------  ---------- ---------- -------- ---------   -----------\n");
 	/* get object information */
 	info = sk_object_get_info(SK_OBJECT_THREAD);
+	/* thread list can't change while printing */
+	sk_sched_lock();
 	sk_list_for_each(entry, &info->obj_list) {
 		thread = (struct sk_thread *)sk_list_entry(entry, struct sk_object, list);
-		sk_kprintf("%s 	 %d	", thread->name, thread->current_pri);
+		sk_kprintf("%s 	 %d  %d	", thread->name, thread->current_pri, thread->oncpu);
 		switch(thread->stat) {
 		case SK_THREAD_READY:
 			sk_kprintf(" ready ");
@@ -60,9 +63,213 @@ static long top()
 			sk_kprintf("close");
 			break;
 		}
-		sk_kprintf("    0x%x 	%d	   %d   	%d\n",thread->sp, thread->stack_size, 10, thread->remain_tick);
+		sk_kprintf("    0x%x 	%d	 %d	   %d   	%d\n",thread->sp, thread->stack_size,
+				   sk_thread_stack_used(thread), 10, thread->remain_tick);
 	}
+	sk_sched_unlock();
 
 	return 0;
 }
 SHELL_CMD_EXPORT(top, show s-kernel version);
+
+static long edf()
+{
+	struct sk_object_info *info;
+	sk_list_t *entry;
+	struct sk_thread *thread;
+
+	sk_kprintf("thread   runtime deadline period  bw(/1000) budget  miss  throttle\n");
+	sk_kprintf("------   ------- -------- ------  ------ ------  ----  --------\n");
+	/* get object information */
+	info = sk_object_get_info(SK_OBJECT_THREAD);
+	/* thread list can't change while printing */
+	sk_sched_lock();
+	sk_list_for_each(entry, &info->obj_list) {
+		thread = (struct sk_thread *)sk_list_entry(entry, struct sk_object, list);
+		if(thread->sched_class != SK_SCHED_CLASS_EDF)
+			continue;
+		sk_kprintf("%s 	 %d	%d	%d	%d	%d	%d	%d\n", thread->name,
+				   thread->edf.runtime, thread->edf.deadline, thread->edf.period,
+				   thread->edf.bandwidth, thread->edf.budget,
+				   thread->edf.miss, thread->edf.throttle);
+	}
+	sk_sched_unlock();
+	sk_kprintf("total density: %d per-mille\n", sk_sched_edf_bandwidth());
+
+	return 0;
+}
+SHELL_CMD_EXPORT(edf, show deadline threads and deadline misses);
+
+static long fair()
+{
+	struct sk_object_info *info;
+	sk_list_t *entry;
+	struct sk_thread *thread;
+
+	sk_kprintf("thread   weight  exec_tick  vruntime\n");
+	sk_kprintf("------   ------  ---------  --------\n");
+	/* get object information */
+	info = sk_object_get_info(SK_OBJECT_THREAD);
+	/* thread list can't change while printing */
+	sk_sched_lock();
+	sk_list_for_each(entry, &info->obj_list) {
+		thread = (struct sk_thread *)sk_list_entry(entry, struct sk_object, list);
+		if(thread->sched_class != SK_SCHED_CLASS_FAIR)
+			continue;
+		sk_kprintf("%s 	 %d	%d	%d\n", thread->name, thread->fair.weight,
+				   (sk_uint32_t)thread->fair.exec_tick,
+				   (sk_uint32_t)(thread->fair.vruntime >> 10));
+	}
+	sk_sched_unlock();
+
+	return 0;
+}
+SHELL_CMD_EXPORT(fair, show fair share threads and their cpu time);
+
+static long stack()
+{
+	struct sk_object_info *info;
+	sk_list_t *entry;
+	struct sk_thread *thread;
+	sk_uint32_t used, recommend, cpu;
+	sk_uint32_t threads = 0, irq_used = 0;
+
+	sk_kprintf("thread   stack_size max_used usage(/100) recommend\n");
+	sk_kprintf("------   ---------- -------- -------- ---------\n");
+	/* get object information */
+	info = sk_object_get_info(SK_OBJECT_THREAD);
+	/* thread list can't change while printing */
+	sk_sched_lock();
+	sk_list_for_each(entry, &info->obj_list) {
+		thread = (struct sk_thread *)sk_list_entry(entry, struct sk_object, list);
+		used = sk_thread_stack_used(thread);
+		/* keep headroom over the high-water mark, 16 bytes aligned */
+		recommend = SK_ALIGN(used + used * SK_THREAD_STACK_HEADROOM / 100, 16);
+		sk_kprintf("%s 	 %d	%d	%d	%d", thread->name, thread->stack_size, used,
+				   used * 100 / thread->stack_size, recommend);
+		if(used >= thread->stack_size)
+			sk_kprintf(" overflow!");
+		sk_kprintf("\n");
+		threads++;
+	}
+	sk_sched_unlock();
+
+	/* interrupt handlers run on the interrupt stack, not on thread stacks */
+	for(cpu = 0; cpu < SK_CPUS_NR; cpu++) {
+		used = sk_irq_stack_used(cpu);
+		if(used > irq_used)
+			irq_used = used;
+		sk_kprintf("irq stack of cpu%d: size %d, max_used %d\n", cpu, SK_IRQ_STACK_SIZE, used);
+	}
+	sk_kprintf("isr budget no longer reserved in %d thread stacks: %d bytes\n",
+			   threads, threads * irq_used);
+
+	return 0;
+}
+SHELL_CMD_EXPORT(stack, show stack high-water mark and recommended size);
+
+#ifdef SK_USING_IRQ_STAT
+/*
+ * print the non-empty buckets of a histogram as "lower bound:count"
+ */
+static void irqstat_hist(const char *name, sk_uint32_t *hist)
+{
+	sk_uint32_t i;
+
+	sk_kprintf("     %s:", name);
+	for(i = 0; i < SK_IRQ_HIST_BUCKETS; i++) {
+		if(hist[i])
+			sk_kprintf(" %d:%d", i ? 1 << i : 0, hist[i]);
+	}
+	sk_kprintf("\n");
+}
+
+static long irqstat()
+{
+	struct sk_irq_stat stat;
+	sk_uint32_t vector;
+
+	sk_kprintf("irq  count      avg_cycles max_cycles max_latency\n");
+	sk_kprintf("---  ---------- ---------- ---------- -----------\n");
+	for(vector = 0; vector < sk_hw_interrupt_max(); vector++) {
+		if(sk_hw_interrupt_get_stat(vector, &stat) != SK_EOK || stat.count == 0)
+			continue;
+		sk_kprintf("%d 	 %d	%d	%d	%d\n", vector, stat.count,
+				   (sk_uint32_t)(stat.cycles_total / stat.count), stat.cycles_max,
+				   stat.latency_max);
+		irqstat_hist("cycles ", stat.cycles_hist);
+		if(stat.latency_max)
+			irqstat_hist("latency", stat.latency_hist);
+	}
+
+	return 0;
+}
+SHELL_CMD_EXPORT(irqstat, show interrupt counts and handler time histograms);
+#endif
+
+#ifdef SK_USING_IRQOFF_PROFILE
+static long irqoff()
+{
+	struct sk_irqoff_record record[SK_IRQOFF_RECORD_NR];
+	sk_uint32_t cpu, count, index;
+
+	sk_kprintf("cpu cycles     disable_caller enable_caller\n");
+	sk_kprintf("--- ---------- -------------- -------------\n");
+	for(cpu = 0; cpu < SK_CPUS_NR; cpu++) {
+		count = sk_irqoff_get(cpu, record, SK_IRQOFF_RECORD_NR);
+		/* kernel is linked below 4G, the low word is the whole address */
+		for(index = 0; index < count; index++) {
+			sk_kprintf("%d   %d	0x%x	0x%x\n", cpu, (sk_uint32_t)record[index].cycles,
+					   (sk_uint32_t)record[index].enter_caller,
+					   (sk_uint32_t)record[index].leave_caller);
+		}
+	}
+
+	return 0;
+}
+SHELL_CMD_EXPORT(irqoff, show the longest interrupts-off sections);
+
+static long irqoff_reset()
+{
+	sk_irqoff_reset();
+	return 0;
+}
+SHELL_CMD_EXPORT(irqoff_reset, drop the interrupts-off section records);
+#endif
+
+static long smp()
+{
+	sk_uint32_t cpu, online = sk_cpu_online_mask();
+
+	sk_kprintf("cpu online reschedule call\n");
+	sk_kprintf("--- ------ ---------- ----\n");
+	for(cpu = 0; cpu < SK_CPUS_NR; cpu++) {
+		sk_kprintf("%d   %s    %d	%d\n", cpu, (online & (1U << cpu)) ? "yes" : "no ",
+				   sk_smp_ipi_count(cpu, SK_IPI_RESCHEDULE),
+				   sk_smp_ipi_count(cpu, SK_IPI_CALL));
+	}
+
+	return 0;
+}
+SHELL_CMD_EXPORT(smp, show online cpus and received inter-processor interrupts);
+
+#ifdef SK_USING_SPINLOCK_STAT
+static long spinlock()
+{
+	sk_list_t *head, *n;
+	sk_spinlock_t *lock;
+
+	sk_kprintf("name             acquire    contend    spin_max   spin_avg\n");
+	sk_kprintf("---------------- ---------- ---------- ---------- ----------\n");
+	head = sk_spin_lock_stat_list();
+	sk_list_for_each(n, head) {
+		lock = sk_list_entry(n, sk_spinlock_t, list);
+		sk_kprintf("%s	%d	%d	%d	%d\n", lock->name, lock->acquire_count,
+				   lock->contend_count, (sk_uint32_t)lock->spin_max,
+				   lock->contend_count ? (sk_uint32_t)(lock->spin_total / lock->contend_count) : 0);
+	}
+
+	return 0;
+}
+SHELL_CMD_EXPORT(spinlock, show spinlock contention statistics);
+#endif
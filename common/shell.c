@@ -21,6 +21,11 @@ static struct shell_syscall *_syscall_table_begin = SK_NULL;
 static struct shell_syscall *_syscall_table_end = SK_NULL;
 static struct shell_cmd *shell = SK_NULL;
 
+/* shell thread and its data are placed statically */
+static struct shell_cmd shell_data;
+static struct sk_thread shell_thread;
+static sk_uint8_t shell_thread_stack[SHELL_THREAD_STACK_SIZE] ALIGN(16);
+
 /*
  * shell_set_device
  * brief
@@ -321,21 +326,19 @@ int shell_system_init(void)
 	_syscall_table_begin = (struct shell_syscall *)&__tsymtab_start;
 	_syscall_table_end   = (struct shell_syscall *)&__tsymtab_end;
 
-	/* create and set shell structure */
-	shell = (struct shell_cmd *)sk_malloc(sizeof(struct shell_cmd));
-	if(shell == SK_NULL) {
-		sk_kprintf("no memory for shell!\n");
-		return -1;
-	}
+	/* set shell structure */
+	shell = &shell_data;
 	sk_memset(shell, 0, sizeof(struct shell_cmd));
 
 	char shell_thread_name[SK_NAME_MAX] = "shell";
 
-	struct sk_thread *thread = sk_thread_create(shell_thread_name,
-												shell_thread_entry,
-												SK_NULL,
-												SHELL_THREAD_STACK_SIZE,
-												SHELL_THREAD_PRIORITY,
-												10);
-	sk_thread_startup(thread);
+	sk_thread_init(&shell_thread,
+				   shell_thread_name,
+				   shell_thread_entry,
+				   SK_NULL,
+				   shell_thread_stack,
+				   SHELL_THREAD_STACK_SIZE,
+				   SHELL_THREAD_PRIORITY,
+				   10);
+	sk_thread_startup(&shell_thread);
 }
@@ -0,0 +1,191 @@
+/*
+ *  workqueue.c
+ *
+ *  brif
+ *      deferred work executed by worker threads
+ *
+ *  (C) 2025.04.22 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+#include <workqueue.h>
+#include <skernel.h>
+#include <config.h>
+#include <hw.h>
+
+static struct sk_workqueue workqueue[SK_WORK_PRIO_NR];
+static sk_uint8_t workqueue_stack[SK_WORK_PRIO_NR][SK_WORKQUEUE_STACK_SIZE] ALIGN(16);
+
+static const sk_uint8_t workqueue_priority[SK_WORK_PRIO_NR] = {
+	SK_WORKQUEUE_PRIO_HIGH,
+	SK_WORKQUEUE_PRIO_NORMAL,
+	SK_WORKQUEUE_PRIO_LOW,
+};
+
+/*
+ * __workqueue_thread_entry
+ * brief
+ * 		worker thread, run the works of its queue one by one in submit order
+ * param
+ * 		param: the work queue
+ */
+static void __workqueue_thread_entry(void *param)
+{
+	struct sk_workqueue *wq = (struct sk_workqueue *)param;
+	struct sk_work *work;
+	sk_base_t level;
+
+	while(1) {
+		sk_sem_wait(&wq->sem, -1);
+
+		/* mask kernel interrupts */
+		level = hw_interrupt_mask_kernel();
+
+		/* the work was cancelled after submitted */
+		if(sk_list_empty(&wq->work_list)) {
+			hw_interrupt_unmask_kernel(level);
+			continue;
+		}
+
+		work = sk_list_entry(wq->work_list.next, struct sk_work, list);
+		sk_list_del(&(work->list));
+		/* the work can be submitted again from now on */
+		work->flag &= ~SK_WORK_FLAG_PENDING;
+		wq->run_count++;
+
+		/* unmask kernel interrupts */
+		hw_interrupt_unmask_kernel(level);
+
+		work->func(work, work->param);
+	}
+}
+
+/*
+ * sk_work_init
+ * brief
+ * 		initialize a work
+ * param
+ * 		work: the work to be initialized
+ * 		func: the work function, called in worker thread
+ * 		param: parameter of work function
+ */
+void sk_work_init(struct sk_work *work, sk_work_func_t func, void *param)
+{
+	sk_list_init(&(work->list));
+	work->func = func;
+	work->param = param;
+	work->flag = 0;
+}
+
+/*
+ * sk_work_submit
+ * brief
+ * 		queue a work to the worker of the given priority. it is safe to be
+ * 		called in interrupt. a work still pending is not queued again
+ * param
+ * 		work: the work to be submitted
+ * 		prio: SK_WORK_PRIO_HIGH, SK_WORK_PRIO_NORMAL or SK_WORK_PRIO_LOW
+ */
+sk_err_t sk_work_submit(struct sk_work *work, sk_uint8_t prio)
+{
+	struct sk_workqueue *wq;
+	sk_base_t level;
+
+	if(prio >= SK_WORK_PRIO_NR)
+		return SK_EINVAL;
+
+	wq = &workqueue[prio];
+
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
+
+	if(work->flag & SK_WORK_FLAG_PENDING) {
+		hw_interrupt_unmask_kernel(level);
+		return SK_EBUSY;
+	}
+
+	work->flag |= SK_WORK_FLAG_PENDING;
+	sk_list_add_tail(&(wq->work_list), &(work->list));
+	wq->submit_count++;
+
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
+
+	/* wake up the worker */
+	sk_sem_post(&(wq->sem));
+
+	return SK_EOK;
+}
+
+/*
+ * sk_work_cancel
+ * brief
+ * 		remove a pending work from its queue. a running work is not stopped
+ * param
+ * 		work: the work to be cancelled
+ */
+sk_err_t sk_work_cancel(struct sk_work *work)
+{
+	sk_base_t level;
+
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
+
+	if(!(work->flag & SK_WORK_FLAG_PENDING)) {
+		hw_interrupt_unmask_kernel(level);
+		return SK_ERROR;
+	}
+
+	sk_list_del(&(work->list));
+	work->flag &= ~SK_WORK_FLAG_PENDING;
+
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
+
+	return SK_EOK;
+}
+
+/*
+ * sk_workqueue_get
+ * brief
+ * 		return the work queue of the given priority
+ * param
+ * 		prio: SK_WORK_PRIO_HIGH, SK_WORK_PRIO_NORMAL or SK_WORK_PRIO_LOW
+ */
+struct sk_workqueue *sk_workqueue_get(sk_uint8_t prio)
+{
+	if(prio >= SK_WORK_PRIO_NR)
+		return SK_NULL;
+
+	return &workqueue[prio];
+}
+
+/*
+ * sk_workqueue_system_init
+ * brief
+ * 		initialize the work queues and start their worker threads
+ */
+void sk_workqueue_system_init(void)
+{
+	char name[SK_NAME_MAX] = "kworker0";
+	sk_uint8_t prio;
+
+	for(prio = 0; prio < SK_WORK_PRIO_NR; prio++) {
+		name[7] = '0' + prio;
+
+		sk_list_init(&(workqueue[prio].work_list));
+		sk_sem_init(&(workqueue[prio].sem), name, 0, SK_IPC_FLAG_FIFO);
+
+		sk_thread_init(&(workqueue[prio].thread),
+					   name,
+					   __workqueue_thread_entry,
+					   &workqueue[prio],
+					   workqueue_stack[prio],
+					   SK_WORKQUEUE_STACK_SIZE,
+					   workqueue_priority[prio],
+					   10);
+		sk_thread_startup(&(workqueue[prio].thread));
+	}
+}
@@ -19,6 +19,7 @@ struct sk_vfs_filesystem_ops file_system_opt[VFS_MAX_FS_TYPE];
 struct sk_vfs_filesystem file_system[VFS_MAX_FS_TYPE];
 struct sk_vfs_fdtable fd_tab;
 struct sk_mutex fs_lock;
+struct sk_rwlock fs_table_lock;
 char working_dir[VFS_MAX_DIRENT_NAME] = {"/"};
 
 /*
@@ -55,6 +56,8 @@ int sk_vfs_init(void)
 	sk_memset(&fd_tab, 0, sizeof(fd_tab));
 	/* create device filesystem lock */
 	sk_mutex_init(&fs_lock, "fslock", SK_IPC_FLAG_FIFO);
+	/* create filesystem table lock, lookups share it */
+	sk_rwlock_init(&fs_table_lock, "fstable", SK_IPC_FLAG_FIFO);
 	/* initialize file description */
 	sk_fdt_init(&fd_tab);
 	/* set current working directory */
@@ -85,6 +88,38 @@ void sk_vfs_unlock()
 	sk_mutex_unlock(&fs_lock);
 }
 
+/*
+ * sk_vfs_table_lock
+ * brief
+ * 		this function will lock the filesystem table. path lookups take it
+ * 		shared, mount and unmount take it exclusive
+ * param
+ * 		write: SK_TRUE to change the table
+ */
+void sk_vfs_table_lock(sk_bool_t write)
+{
+	/* wait rwlock forever */
+	if(write)
+		sk_rwlock_write_lock(&fs_table_lock, -1);
+	else
+		sk_rwlock_read_lock(&fs_table_lock, -1);
+}
+
+/*
+ * sk_vfs_table_unlock
+ * brief
+ * 		this function will unlock the filesystem table
+ * param
+ * 		write: SK_TRUE if it was locked to change the table
+ */
+void sk_vfs_table_unlock(sk_bool_t write)
+{
+	if(write)
+		sk_rwlock_write_unlock(&fs_table_lock);
+	else
+		sk_rwlock_read_unlock(&fs_table_lock);
+}
+
 
 /*
  * sk_fd_alloc
@@ -27,8 +27,8 @@ struct sk_vfs_filesystem *sk_vfs_filesystem_lookup(const char *path)
 	struct sk_vfs_filesystem *iter;
 	struct sk_vfs_filesystem *fs = SK_NULL;
 
-	/* lock filesystem */
-	sk_vfs_lock();
+	/* lock filesystem table, lookups run in parallel */
+	sk_vfs_table_lock(SK_FALSE);
 
 	/* lookup it in filesystem table */
 	for(iter = &file_system[0]; iter < &file_system[VFS_MAX_FS_TYPE]; iter++) {
@@ -41,8 +41,8 @@ struct sk_vfs_filesystem *sk_vfs_filesystem_lookup(const char *path)
 	if(iter < &file_system[VFS_MAX_FS_TYPE])
 		fs = iter;
 
-	/* unlock filesystem */
-	sk_vfs_unlock();
+	/* unlock filesystem table */
+	sk_vfs_table_unlock(SK_FALSE);
 
 	return fs;
 }
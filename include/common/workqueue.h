@@ -0,0 +1,67 @@
+/*
+ *  workqueue.h
+ *
+ *  brif
+ *      deferred work executed by worker threads
+ *
+ *  (C) 2025.04.22 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+#ifndef __WORKQUEUE_H_
+#define __WORKQUEUE_H_
+
+#include <base_def.h>
+#include <klist.h>
+#include <sched.h>
+#include <ipc.h>
+
+/*
+ * worker threads, one for each priority
+ */
+#define SK_WORK_PRIO_HIGH 		0x00
+#define SK_WORK_PRIO_NORMAL 	0x01
+#define SK_WORK_PRIO_LOW 		0x02
+#define SK_WORK_PRIO_NR 		0x03
+
+#define SK_WORK_FLAG_PENDING 	0x01		/* queued and not started yet */
+
+struct sk_work;
+typedef void (*sk_work_func_t)(struct sk_work *work, void *param);
+
+/*
+ * work structure
+ */
+struct sk_work
+{
+	sk_list_t 		list;					/* node in work list of the queue */
+	sk_work_func_t 	func;					/* work function */
+	void 			*param;					/* parameter of work function */
+	sk_uint8_t 		flag;					/* work flag */
+};
+
+/*
+ * work queue structure
+ */
+struct sk_workqueue
+{
+	sk_list_t 		 work_list;				/* pending works */
+	struct sk_sem 	 sem;					/* counts submitted works */
+	struct sk_thread thread;				/* worker thread */
+
+	sk_uint32_t 	 submit_count;			/* number of submitted works */
+	sk_uint32_t 	 run_count;				/* number of executed works */
+};
+
+/*
+ * work queue interfaces
+ */
+void sk_work_init(struct sk_work *work, sk_work_func_t func, void *param);
+sk_err_t sk_work_submit(struct sk_work *work, sk_uint8_t prio);
+sk_err_t sk_work_cancel(struct sk_work *work);
+struct sk_workqueue *sk_workqueue_get(sk_uint8_t prio);
+void sk_workqueue_system_init(void);
+
+#endif
@@ -13,7 +13,9 @@
 #ifndef __CONFIG_H_
 #define __CONFIG_H_
 
+#ifndef __ASSEMBLY__
 #include "base_def.h"
+#endif
 
 /* s-kernel version information */
 #define SK_VERSION			1L		/* major version number */
@@ -29,11 +31,47 @@
 /* dist and cpu definitions */
 #define GIC_DIST_BASE 				0x08000000
 #define GIC_CPU_BASE				0x08010000
+#define GIC_REDIST_BASE 			0x080A0000	/* gicv3 redistributors */
+/* #define SK_USING_GICV3 */					/* gicv3 backend, run with gic-version=3 */
 #define GIC_IRQ_START 				0
-#define GIC_MAX_HANDLERS 			96
+#define SK_IRQ_PRIORITY_DEFAULT 	0xa0		/* gic priority of interrupts, lower value is more urgent */
+#define SK_IRQ_PRIORITY_TICK 		0x80		/* gic priority of system tick */
+#define SK_IRQ_PRIORITY_IPI 		0x60		/* gic priority of inter-processor interrupts */
+#define SK_IRQ_KERNEL_PRIORITY 		0x40		/* more urgent irqs run through kernel critical sections, no kernel api */
+#define SK_USING_IRQ_NESTING 					/* higher priority interrupts preempt handlers */
+#define SK_USING_IRQ_STAT 						/* per vector count, handler time and latency */
+/* #define SK_USING_IRQOFF_PROFILE */				/* record the longest interrupts-off sections */
+#define SK_IRQOFF_RECORD_NR 		8			/* number of sections kept by the profiler */
 
 #define TICK_PER_SECOND 			1000
 
+/* cpu */
+#define SK_CPUS_NR 					1			/* number of cpu cores */
+#define SK_IRQ_STACK_SIZE 			4096		/* interrupt stack size of each cpu */
+#define SK_SMP_BOOT_STACK_SIZE 		2048		/* boot and idle stack of each secondary cpu */
+#define SK_USING_IRQ_FAST_ENTRY 				/* save only caller-saved registers on irq */
+/* #define SK_USING_SPINLOCK_STAT */				/* per lock acquisitions, contentions and spin time */
+
+/* scheduler */
+#define SK_SCHED_EDF_PRIORITY 		8			/* priority band served by the EDF class */
+#define SK_SCHED_EDF_BW_MAX 		950			/* EDF admission limit of total density, per-mille */
+#define SK_SCHED_FAIR_PRIORITY 		30			/* priority band served by the fair class */
+#define SK_SCHED_FAIR_WEIGHT 		1024		/* default weight of fair thread */
+#define SK_SCHED_FAIR_GRANULARITY 	4			/* min ticks before a fair thread is preempted */
+
+/* ipc */
+#define SK_MQ_PRIO_BANDS 			4			/* max priority bands of message queue, band 0 first */
+
+/* work queue */
+#define SK_WORKQUEUE_STACK_SIZE 	2048		/* stack size of each worker thread */
+#define SK_WORKQUEUE_PRIO_HIGH 		4			/* thread priority of high priority worker */
+#define SK_WORKQUEUE_PRIO_NORMAL 	16			/* thread priority of normal priority worker */
+#define SK_WORKQUEUE_PRIO_LOW 		26			/* thread priority of low priority worker */
+
+/* thread stack */
+#define SK_USING_STACK_CHECK 					/* check stack overflow at context switch */
+#define SK_THREAD_STACK_HEADROOM 	25			/* headroom of recommended stack size, percent */
+
 /* uart */
 #define PL011_UART_DR 				0x000
 #define PL011_UART_FR  				0x018
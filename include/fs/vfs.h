@@ -121,6 +121,8 @@ struct sk_vfs_fdtable
 /* vfs interfaces */
 void sk_vfs_lock();
 void sk_vfs_unlock();
+void sk_vfs_table_lock(sk_bool_t write);
+void sk_vfs_table_unlock(sk_bool_t write);
 int sk_fd_new();
 struct sk_vfs_fd *sk_get_fd(int fd);
 void sk_put_fd(struct sk_vfs_fd *fd);
@@ -0,0 +1,217 @@
+/*
+ *  atomic.h
+ *  brief
+ *  	atomic operations of s-kernel, built on the exclusive load and store
+ *  	instructions of armv8. the armv8.1 large system extension atomics are
+ *  	used instead when the cpu has them, see sk_atomic_init()
+ *  	exclusives are only guaranteed on normal cacheable memory, they must
+ *  	not be used before mmu_enable() of the cpu
+ *
+ *  (C) 2025.04.27 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#ifndef __ATOMIC_H_
+#define __ATOMIC_H_
+
+#include <base_def.h>
+
+/* the cpu implements the lse atomic instructions */
+extern sk_bool_t sk_atomic_lse;
+
+void sk_atomic_init(void);
+
+/*
+ * compare and exchange
+ * brief
+ * 		store new to *ptr if it holds old. acquire makes the accesses after
+ * 		a successful exchange stay after it, release makes the accesses
+ * 		before it stay before it. nothing is stored and no order is given
+ * 		when the compare fails
+ * return
+ * 		the value read from *ptr, the exchange is done if it equals old
+ */
+#define __SK_ATOMIC_CMPXCHG(name, type, sz, r, ld, st, cas)						\
+static inline type sk_atomic_cmpxchg##name(volatile type *ptr, type old, type new)	\
+{																				\
+	sk_ubase_t val, tmp;														\
+																				\
+	if(sk_atomic_lse) {															\
+		val = (sk_ubase_t)old;													\
+		__asm__ volatile (														\
+		"	.arch_extension lse\n"												\
+		"	" cas sz " 	%" r "0, %" r "2, %1\n"									\
+		: "+r" (val), "+Q" (*ptr)												\
+		: "r" ((sk_ubase_t)new)													\
+		: "memory");															\
+																				\
+		return (type)val;														\
+	}																			\
+																				\
+	__asm__ volatile (															\
+	"1:	" ld sz " 	%" r "0, %2\n"												\
+	"	cmp 	%" r "0, %" r "3\n"												\
+	"	b.ne 	2f\n"															\
+	"	" st sz " 	%w1, %" r "4, %2\n"											\
+	"	cbnz 	%w1, 1b\n"														\
+	"2:"																		\
+	: "=&r" (val), "=&r" (tmp), "+Q" (*ptr)										\
+	: "r" ((sk_ubase_t)old), "r" ((sk_ubase_t)new)								\
+	: "cc", "memory");															\
+																				\
+	return (type)val;															\
+}
+
+__SK_ATOMIC_CMPXCHG(16_acquire, sk_uint16_t, "h", "w", "ldaxr", "stxr", "casa")
+__SK_ATOMIC_CMPXCHG(16_release, sk_uint16_t, "h", "w", "ldxr", "stlxr", "casl")
+__SK_ATOMIC_CMPXCHG(32_acquire, sk_uint32_t, "", "w", "ldaxr", "stxr", "casa")
+__SK_ATOMIC_CMPXCHG(32_release, sk_uint32_t, "", "w", "ldxr", "stlxr", "casl")
+__SK_ATOMIC_CMPXCHG(64_acquire, sk_uint64_t, "", "x", "ldaxr", "stxr", "casa")
+__SK_ATOMIC_CMPXCHG(64_release, sk_uint64_t, "", "x", "ldxr", "stlxr", "casl")
+
+/*
+ * load acquire and store release
+ */
+#define __SK_ATOMIC_LOAD_STORE(bits, type, sz, r)								\
+static inline type sk_atomic_load##bits##_acquire(volatile type *ptr)			\
+{																				\
+	sk_ubase_t val;																\
+																				\
+	__asm__ volatile ("ldar" sz " 	%" r "0, %1"								\
+					  : "=r" (val) : "Q" (*ptr) : "memory");					\
+																				\
+	return (type)val;															\
+}																				\
+																				\
+static inline void sk_atomic_store##bits##_release(volatile type *ptr, type val)	\
+{																				\
+	__asm__ volatile ("stlr" sz " 	%" r "1, %0"								\
+					  : "=Q" (*ptr) : "r" ((sk_ubase_t)val) : "memory");		\
+}
+
+__SK_ATOMIC_LOAD_STORE(16, sk_uint16_t, "h", "w")
+__SK_ATOMIC_LOAD_STORE(32, sk_uint32_t, "", "w")
+__SK_ATOMIC_LOAD_STORE(64, sk_uint64_t, "", "x")
+
+/*
+ * read-modify-write
+ * brief
+ * 		apply op to *ptr with val, ordered as both acquire and release
+ * return
+ * 		the value of *ptr before the operation
+ */
+#define __SK_ATOMIC_FETCH_OP(name, bits, type, r, op, lse_op, lse_val)			\
+static inline type sk_atomic_fetch_##name##bits(volatile type *ptr, type val)	\
+{																				\
+	sk_ubase_t old, res, tmp;													\
+																				\
+	if(sk_atomic_lse) {															\
+		__asm__ volatile (														\
+		"	.arch_extension lse\n"												\
+		"	" lse_op " 	%" r "2, %" r "0, %1\n"									\
+		: "=r" (old), "+Q" (*ptr)												\
+		: "r" ((sk_ubase_t)(lse_val))											\
+		: "memory");															\
+																				\
+		return (type)old;														\
+	}																			\
+																				\
+	__asm__ volatile (															\
+	"1:	ldaxr 	%" r "0, %3\n"													\
+	"	" op " 	%" r "1, %" r "0, %" r "4\n"									\
+	"	stlxr 	%w2, %" r "1, %3\n"												\
+	"	cbnz 	%w2, 1b\n"														\
+	: "=&r" (old), "=&r" (res), "=&r" (tmp), "+Q" (*ptr)						\
+	: "r" ((sk_ubase_t)val)														\
+	: "memory");																\
+																				\
+	return (type)old;															\
+}
+
+__SK_ATOMIC_FETCH_OP(add, 32, sk_uint32_t, "w", "add", "ldaddal", val)
+__SK_ATOMIC_FETCH_OP(or, 32, sk_uint32_t, "w", "orr", "ldsetal", val)
+__SK_ATOMIC_FETCH_OP(and, 32, sk_uint32_t, "w", "and", "ldclral", ~val)
+__SK_ATOMIC_FETCH_OP(xor, 32, sk_uint32_t, "w", "eor", "ldeoral", val)
+__SK_ATOMIC_FETCH_OP(add, 64, sk_uint64_t, "x", "add", "ldaddal", val)
+__SK_ATOMIC_FETCH_OP(or, 64, sk_uint64_t, "x", "orr", "ldsetal", val)
+__SK_ATOMIC_FETCH_OP(and, 64, sk_uint64_t, "x", "and", "ldclral", ~val)
+__SK_ATOMIC_FETCH_OP(xor, 64, sk_uint64_t, "x", "eor", "ldeoral", val)
+
+static inline sk_uint32_t sk_atomic_fetch_sub32(volatile sk_uint32_t *ptr, sk_uint32_t val)
+{
+	return sk_atomic_fetch_add32(ptr, -val);
+}
+
+static inline sk_uint64_t sk_atomic_fetch_sub64(volatile sk_uint64_t *ptr, sk_uint64_t val)
+{
+	return sk_atomic_fetch_add64(ptr, -val);
+}
+
+/*
+ * exchange
+ * brief
+ * 		store val to *ptr, ordered as both acquire and release
+ * return
+ * 		the value of *ptr before the exchange
+ */
+#define __SK_ATOMIC_XCHG(bits, type, r)											\
+static inline type sk_atomic_xchg##bits(volatile type *ptr, type val)			\
+{																				\
+	sk_ubase_t old, tmp;														\
+																				\
+	if(sk_atomic_lse) {															\
+		__asm__ volatile (														\
+		"	.arch_extension lse\n"												\
+		"	swpal 	%" r "2, %" r "0, %1\n"										\
+		: "=r" (old), "+Q" (*ptr)												\
+		: "r" ((sk_ubase_t)val)													\
+		: "memory");															\
+																				\
+		return (type)old;														\
+	}																			\
+																				\
+	__asm__ volatile (															\
+	"1:	ldaxr 	%" r "0, %2\n"													\
+	"	stlxr 	%w1, %" r "3, %2\n"												\
+	"	cbnz 	%w1, 1b\n"														\
+	: "=&r" (old), "=&r" (tmp), "+Q" (*ptr)										\
+	: "r" ((sk_ubase_t)val)														\
+	: "memory");																\
+																				\
+	return (type)old;															\
+}
+
+__SK_ATOMIC_XCHG(32, sk_uint32_t, "w")
+__SK_ATOMIC_XCHG(64, sk_uint64_t, "x")
+
+/*
+ * bit operations on a bitmap of sk_uint64_t words, nr is the bit index
+ */
+#define SK_ATOMIC_BIT_WORD(nr) 		((nr) / 64U)
+#define SK_ATOMIC_BIT_MASK(nr) 		(1UL << ((nr) % 64U))
+
+static inline void sk_atomic_set_bit(sk_uint32_t nr, volatile sk_uint64_t *addr)
+{
+	sk_atomic_fetch_or64(addr + SK_ATOMIC_BIT_WORD(nr), SK_ATOMIC_BIT_MASK(nr));
+}
+
+static inline void sk_atomic_clear_bit(sk_uint32_t nr, volatile sk_uint64_t *addr)
+{
+	sk_atomic_fetch_and64(addr + SK_ATOMIC_BIT_WORD(nr), ~SK_ATOMIC_BIT_MASK(nr));
+}
+
+static inline sk_bool_t sk_atomic_test_and_set_bit(sk_uint32_t nr, volatile sk_uint64_t *addr)
+{
+	return (sk_atomic_fetch_or64(addr + SK_ATOMIC_BIT_WORD(nr), SK_ATOMIC_BIT_MASK(nr))
+			& SK_ATOMIC_BIT_MASK(nr)) != 0;
+}
+
+static inline sk_bool_t sk_atomic_test_and_clear_bit(sk_uint32_t nr, volatile sk_uint64_t *addr)
+{
+	return (sk_atomic_fetch_and64(addr + SK_ATOMIC_BIT_WORD(nr), ~SK_ATOMIC_BIT_MASK(nr))
+			& SK_ATOMIC_BIT_MASK(nr)) != 0;
+}
+
+#endif
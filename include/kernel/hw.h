@@ -15,6 +15,9 @@
 
 #include <base_def.h>
 
+#ifndef __REG64
+#define __REG64(x)							(*((volatile sk_uint64_t *)(x)))
+#endif
 #ifndef __REG32
 #define __REG32(x)							(*((volatile sk_uint32_t *)(x)))
 #endif
@@ -36,10 +39,64 @@ enum HW_CACHE_OPS
  */
 typedef void (*sk_isr_handler_t)(int vector, void *param);
 
+/* interrupt descriptor flags */
+#define SK_IRQ_FLAG_SHARED 			0x01		/* line shared by several handlers */
+#define SK_IRQ_FLAG_THREADED 		0x02		/* handler runs in a worker thread */
+
+/* interrupt id of the acknowledge value, the upper bits hold the sgi source cpu */
+#define SK_IRQ_ID_MASK 				0x3FF
+
+struct sk_irq_stat;
+struct sk_irq_thread;
+
+/*
+ * extra handler of a shared interrupt
+ */
+struct sk_irq_action
+{
+	sk_isr_handler_t 	 handler;
+	void 				 *param;
+	struct sk_irq_action *next;
+};
+
+/*
+ * interrupt descriptor, one for each interrupt the controller supports
+ */
 struct sk_irq_desc
 {
-	sk_isr_handler_t handler;
+	sk_isr_handler_t handler;					/* first handler */
 	void 			*param;
+	struct sk_irq_action *action;				/* handlers sharing the line */
+	sk_uint32_t 	flags;						/* SK_IRQ_FLAG_XXX */
+	sk_uint32_t 	count;						/* number of times the irq is taken */
+	struct sk_irq_stat *stat;					/* statistics, allocated on install */
+	struct sk_irq_thread *thread;				/* threaded bottom half, kept once allocated */
+};
+
+/* bucket n counts the cycles in [2^n, 2^(n+1)), the last one takes the rest */
+#define SK_IRQ_HIST_BUCKETS 		16
+
+/*
+ * interrupt statistics of a vector, time in generic counter cycles
+ */
+struct sk_irq_stat
+{
+	sk_uint32_t count;							/* number of handler runs */
+	sk_uint32_t cycles_max;						/* longest handler run */
+	sk_uint64_t cycles_total;					/* total time in handler */
+	sk_uint32_t latency_max;					/* worst entry latency */
+	sk_uint32_t cycles_hist[SK_IRQ_HIST_BUCKETS];	/* handler time histogram */
+	sk_uint32_t latency_hist[SK_IRQ_HIST_BUCKETS];	/* entry latency histogram */
+};
+
+/*
+ * the longest interrupts-off section, time in generic counter cycles
+ */
+struct sk_irqoff_record
+{
+	sk_uint64_t cycles;							/* interrupts masked time */
+	sk_ubase_t 	enter_caller;					/* return address of hw_interrupt_disable() */
+	sk_ubase_t 	leave_caller;					/* return address of hw_interrupt_enable() */
 };
 
 /*
@@ -48,12 +105,38 @@ struct sk_irq_desc
 void sk_hw_interrupt_mask(int vector);
 void sk_hw_interrupt_umask(int vector);
 void sk_hw_interrupt_ack(int vector);
+void sk_hw_interrupt_set_pending(int vector);
+void sk_hw_interrupt_send_ipi(int vector, sk_uint32_t cpu_mask);
+void sk_hw_interrupt_set_priority(int vector, sk_uint8_t priority);
+sk_uint8_t sk_hw_interrupt_get_priority(int vector);
 sk_int32_t sk_hw_interrupt_get_irq(void);
 sk_isr_handler_t sk_hw_interrupt_install(int vector, sk_isr_handler_t handler, void *param);
+sk_err_t sk_hw_interrupt_install_shared(int vector, sk_isr_handler_t handler, void *param);
+struct sk_irq_desc *sk_hw_interrupt_get_desc(int vector);
+sk_uint32_t sk_hw_interrupt_max(void);
+sk_err_t sk_hw_interrupt_install_threaded(int vector, sk_isr_handler_t handler,
+										  void *param, sk_uint8_t prio);
+void sk_hw_interrupt_record_time(int vector, sk_uint64_t cycles);
+void sk_hw_interrupt_record_latency(int vector, sk_uint64_t cycles);
+sk_err_t sk_hw_interrupt_get_stat(int vector, struct sk_irq_stat *stat);
+void sk_hw_interrupt_clear_stat(int vector);
 void sk_hw_interrupt_init(void);
+void sk_hw_interrupt_cpu_init(void);
+void sk_hw_vector_init(void);
 
 sk_base_t hw_interrupt_disable();
 void hw_interrupt_enable(sk_base_t level);
+sk_base_t hw_interrupt_mask_kernel(void);
+void hw_interrupt_unmask_kernel(sk_base_t level);
+sk_ubase_t hw_cpu_id(void);
+void hw_cpu_enter_idle(void (*entry)(void));
+sk_base_t hw_psci_call(sk_ubase_t function, sk_ubase_t arg0, sk_ubase_t arg1, sk_ubase_t arg2);
+sk_base_t sk_irqoff_enter(sk_base_t level, sk_ubase_t caller);
+void sk_irqoff_leave(sk_base_t level, sk_ubase_t caller);
+sk_uint32_t sk_irqoff_get(sk_uint32_t cpu, struct sk_irqoff_record *record, sk_uint32_t size);
+void sk_irqoff_reset(void);
+sk_ubase_t sk_irq_stack_top(void);
+sk_uint32_t sk_irq_stack_used(sk_uint32_t cpu);
 
 /*
  * context interfaces
@@ -61,6 +144,7 @@ void hw_interrupt_enable(sk_base_t level);
 void hw_context_switch(sk_ubase_t from, sk_ubase_t to);
 void hw_context_switch_interrupt(sk_ubase_t from, sk_ubase_t to);
 void hw_context_switch_to(sk_ubase_t to);
+sk_ubase_t hw_thread_sp(void);
 
 #endif
 
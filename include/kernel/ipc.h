@@ -25,8 +25,16 @@
 #define SK_IPC_FLAG_PRIO 	0x01 		/* PRIO IPC */
 
 #define SK_MUTEX_HOLD_MAX	0xFF 		/* maxium number of mutex */
+#define SK_MUTEX_CONTENDED 	0x01 		/* owner bit, threads are waiting for the mutex */
 #define SK_SEM_VALUE_MAX 	0xFFFF 		/* maxium number of semaphore */
 
+#define SK_RWLOCK_WRITER 	0x80000000 	/* state bit, held by a writer */
+#define SK_RWLOCK_WAITING 	0x40000000 	/* state bit, threads are waiting */
+#define SK_RWLOCK_READERS 	0x3FFFFFFF 	/* state bits, number of readers holding */
+
+#define SK_MQ_CTRL_SET_BANDS 	0x01 	/* set number of priority bands of an empty queue */
+#define SK_MQ_CTRL_GET_BANDS 	0x02 	/* get number of priority bands */
+
 #define SK_EVENT_FLAG_AND 	0x01 		/* logic and */
 #define SK_EVENT_FLAG_OR 	0x02 		/* logic or */
 #define SK_EVENT_FLAG_CLEAR 0x04 		/* clear flag */
@@ -50,10 +58,35 @@ struct sk_mutex
 
 	sk_uint16_t 		 value;			/* value of mutex */
 
-	sk_uint8_t 			 original_pri;	/* priority of last thread hold the mutex */
 	sk_uint8_t 			 hold; 			/* numbers of thread hold the mutex */
+	sk_uint8_t 			 priority;		/* highest priority of waiting threads */
+
+	sk_uint64_t 		 owner;			/* current owner thread of mutex, 0 if free */
+	sk_list_t 			 taken_list;	/* node in owner's taken mutex list */
+};
+
+/*
+ * reader-writer lock structure, readers share the lock and a waiting
+ * writer keeps new readers out
+ */
+struct sk_rwlock
+{
+	struct sk_ipc_object parent;		/* inherit from ipc_object, readers suspended */
+
+	sk_uint32_t 		 state;			/* SK_RWLOCK_XXX bits and number of readers */
+	struct sk_thread 	 *writer;		/* writer holding the lock */
 
-	struct sk_thread 	 *owner;		/* current owner of mutex */
+	sk_list_t 			 suspend_writer_thread;	/* writer thread suspended on this lock */
+};
+
+/*
+ * condition variable structure, used together with a mutex
+ */
+struct sk_cond
+{
+	struct sk_ipc_object parent;		/* inherit from ipc_object */
+
+	struct sk_mutex 	 *mutex;		/* mutex released by the waiters */
 };
 
 /*
@@ -106,9 +139,11 @@ struct sk_msg_queue
 
 	sk_uint16_t 	entry;				/*  index of messages in the queue */
 
-	void 			*msg_queue_head;	/* list head */
-	void 			*msg_queue_tail; 	/* list tail */
+	void 			*msg_queue_head[SK_MQ_PRIO_BANDS];	/* list head of each band */
+	void 			*msg_queue_tail[SK_MQ_PRIO_BANDS]; 	/* list tail of each band */
 	void 			*msg_queue_free;	/* pointer indicated the free node of queue */
+	sk_uint32_t 	band_map;			/* bitmap of bands holding messages */
+	sk_uint8_t 		bands;				/* number of priority bands in use */
 
 	sk_list_t 		suspend_sender_thread;	/* sender thread suspended on this message queue */
 };
@@ -122,6 +157,25 @@ sk_err_t sk_mutex_trylock(struct sk_mutex *mutex);
 sk_err_t sk_mutex_unlock(struct sk_mutex *mutex);
 
 
+/* reader-writer lock relative interface */
+sk_err_t sk_rwlock_init(struct sk_rwlock *rwlock, const char *name, sk_uint8_t flag);
+struct sk_rwlock *sk_rwlock_create(const char *name, sk_uint8_t flag);
+sk_err_t sk_rwlock_delete(struct sk_rwlock *rwlock);
+sk_err_t sk_rwlock_read_lock(struct sk_rwlock *rwlock, sk_int32_t time);
+sk_err_t sk_rwlock_read_trylock(struct sk_rwlock *rwlock);
+sk_err_t sk_rwlock_read_unlock(struct sk_rwlock *rwlock);
+sk_err_t sk_rwlock_write_lock(struct sk_rwlock *rwlock, sk_int32_t time);
+sk_err_t sk_rwlock_write_trylock(struct sk_rwlock *rwlock);
+sk_err_t sk_rwlock_write_unlock(struct sk_rwlock *rwlock);
+
+/* condition variable relative interface */
+sk_err_t sk_cond_init(struct sk_cond *cond, const char *name, sk_uint8_t flag);
+struct sk_cond *sk_cond_create(const char *name, sk_uint8_t flag);
+sk_err_t sk_cond_delete(struct sk_cond *cond);
+sk_err_t sk_cond_wait(struct sk_cond *cond, struct sk_mutex *mutex, sk_int32_t time);
+sk_err_t sk_cond_signal(struct sk_cond *cond);
+sk_err_t sk_cond_broadcast(struct sk_cond *cond);
+
 /* semaphore relative interface */
 sk_err_t sk_sem_init(struct sk_sem *sem, const char *name, 
 					 sk_uint16_t value, sk_uint8_t flag);
@@ -146,6 +200,8 @@ sk_err_t sk_mailbox_delete(struct sk_mailbox *mb);
 sk_err_t sk_mailbox_send_wait(struct sk_mailbox *mb, sk_ubase_t value, sk_int32_t timeout);
 sk_err_t sk_mailbox_send(struct sk_mailbox *mb, sk_ubase_t value);
 sk_err_t sk_mailbox_recv(struct sk_mailbox *mb, sk_ubase_t *value, sk_int32_t timeout);
+sk_int32_t sk_mailbox_send_n(struct sk_mailbox *mb, const sk_ubase_t *value, sk_size_t count, sk_int32_t timeout);
+sk_int32_t sk_mailbox_recv_n(struct sk_mailbox *mb, sk_ubase_t *value, sk_size_t count, sk_int32_t timeout);
 
 /* message queue interface */
 struct sk_msg_queue *sk_msg_queue_create(const char *name, sk_size_t msg_size, sk_size_t max_msgs, sk_uint8_t flag);
@@ -154,5 +210,14 @@ sk_err_t sk_msg_queue_delete(struct sk_msg_queue *mq);
 sk_err_t sk_msg_queue_send_wait(struct sk_msg_queue *mq, const void *buffer, sk_size_t size, sk_int32_t timeout);
 sk_err_t sk_msg_queue_send(struct sk_msg_queue *mq, const void *buffer, sk_size_t size);
 sk_err_t sk_msg_queue_recv(struct sk_msg_queue *mq, void *buffer, sk_size_t size, sk_int32_t timeout);
+sk_err_t sk_msg_queue_send_prio(struct sk_msg_queue *mq, const void *buffer, sk_size_t size, sk_uint8_t prio, sk_int32_t timeout);
+sk_err_t sk_msg_queue_urgent(struct sk_msg_queue *mq, const void *buffer, sk_size_t size);
+sk_err_t sk_msg_queue_control(struct sk_msg_queue *mq, int cmd, void *arg);
+sk_int32_t sk_msg_queue_send_n(struct sk_msg_queue *mq, const void *buffer, sk_size_t size, sk_size_t count, sk_int32_t timeout);
+sk_int32_t sk_msg_queue_recv_n(struct sk_msg_queue *mq, void *buffer, sk_size_t size, sk_size_t count, sk_int32_t timeout);
+sk_err_t sk_msg_queue_reserve(struct sk_msg_queue *mq, void **buffer, sk_int32_t timeout);
+sk_err_t sk_msg_queue_commit(struct sk_msg_queue *mq, void *buffer, sk_size_t size);
+sk_err_t sk_msg_queue_peek(struct sk_msg_queue *mq, void **buffer, sk_size_t *size, sk_int32_t timeout);
+sk_err_t sk_msg_queue_release(struct sk_msg_queue *mq, void *buffer);
 
 #endif
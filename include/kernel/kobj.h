@@ -38,6 +38,8 @@ enum sk_object_type {
 	SK_OBJECT_EVENT,	 					/* event object */
 	SK_OBJECT_MAILBOX,	 					/* mailbox object */
 	SK_OBJECT_MSQUE,	 					/* message queue object */
+	SK_OBJECT_RWLOCK,	 					/* reader-writer lock object */
+	SK_OBJECT_COND,	 						/* condition variable object */
 	SK_OBJECT_DEVICE,	 					/* device object */
 	SK_OBJECT_TIMER,	 					/* tick object */
 	SK_OBJECT_UNKNOWN,
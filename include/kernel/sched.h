@@ -13,6 +13,7 @@
 #define __SCHED_H_
 
 #include <base_def.h>
+#include <config.h>
 #include <timer.h>
 
 /*
@@ -27,9 +28,88 @@
 
 #define SK_THREAD_YIELD 		(0x10)
 
+/* thread stack is painted with this pattern to measure the usage */
+#define SK_THREAD_STACK_MAGIC 	(0x23232323)
+
 /* thread priority */
 #define SK_THREAD_PRIORITY_MAX 	(32)			/* support max priority */
 
+/* thread control command */
+#define SK_THREAD_CTRL_CHANGE_PRIORITY 	(0x00)	/* change current priority */
+#define SK_THREAD_CTRL_BIND_CPU 		(0x01)	/* set cpu affinity mask */
+#define SK_THREAD_CTRL_INHERIT_PRIORITY (0x02)	/* change current priority by priority inheritance */
+
+/* affinity mask of all cpus */
+#define SK_CPU_MASK_ALL 		((1U << SK_CPUS_NR) - 1)
+/* cpus that schedule threads, secondary cpus only serve ipis */
+#define SK_CPU_MASK_SCHED 		(1U << 0)
+
+/* scheduling class */
+#define SK_SCHED_CLASS_RT 		(0x00)			/* fixed priority, round robin */
+#define SK_SCHED_CLASS_EDF 		(0x01)			/* earliest deadline first */
+#define SK_SCHED_CLASS_FAIR 	(0x02)			/* weighted fair share */
+
+/* priority bands reserved for the scheduling classes */
+#define SK_SCHED_CLASS_BAND(prio) 	((prio) == SK_SCHED_EDF_PRIORITY || (prio) == SK_SCHED_FAIR_PRIORITY)
+
+/*
+ * deadline scheduling parameters, all times in ticks
+ */
+struct sk_sched_edf
+{
+	sk_tick_t 	runtime;						/* budget of each period */
+	sk_tick_t 	deadline;						/* relative deadline */
+	sk_tick_t 	period;							/* activation period */
+	sk_uint32_t bandwidth;						/* runtime / min(deadline, period), per-mille */
+
+	sk_tick_t 	abs_deadline;					/* absolute deadline of current job */
+	sk_tick_t 	budget;							/* remaining budget of current job */
+	sk_tick_t 	release;						/* release tick of next job */
+	sk_uint8_t 	missed;							/* current job has missed its deadline */
+	sk_uint32_t miss;							/* number of deadline misses */
+	sk_uint32_t throttle;						/* number of budget overruns */
+};
+
+/*
+ * fair share scheduling parameters
+ */
+struct sk_sched_fair
+{
+	sk_uint32_t weight;							/* share of cpu relative to other fair threads */
+	sk_uint64_t vruntime;						/* weighted virtual runtime */
+	sk_uint64_t exec_tick;						/* ticks really consumed */
+};
+
+struct sk_mutex;
+
+/*
+ * per-cpu scheduler data
+ */
+struct sk_cpu
+{
+	sk_uint8_t 	id;								/* cpu index */
+	struct sk_thread *current_thread;			/* thread running on this cpu */
+
+	sk_uint8_t 	irq_nest;						/* interrupt nest level */
+	sk_uint8_t 	irq_nest_max;					/* deepest interrupt nest level */
+	sk_uint8_t 	need_resched;					/* reschedule requested in interrupt */
+	sk_uint8_t 	reserved;
+	sk_uint16_t sched_lock_nest;				/* scheduler lock nest level */
+
+	sk_uint32_t resched_request;				/* number of deferred reschedule requests */
+	sk_uint32_t schedule_count;					/* number of scheduler runs */
+	sk_uint32_t switch_count;					/* number of context switches */
+};
+
+/*
+ * inter-processor interrupts, sent as gic sgis of the same number
+ */
+#define SK_IPI_RESCHEDULE 		0x00			/* reschedule on the way out of interrupt */
+#define SK_IPI_CALL 			0x01			/* run a function on the target cpu */
+#define SK_IPI_NR 				0x02
+
+typedef void (*sk_smp_call_func_t)(void *param);
+
 /*
  * thread structure
  */
@@ -46,7 +126,13 @@ struct sk_thread
 	sk_uint8_t 	stat;							/* thread state */
 	sk_uint8_t 	current_pri;					/* current priority */
 	sk_uint8_t 	init_pri;						/* initialized priority */
+	sk_uint8_t 	base_pri;						/* priority without inheritance */
 	sk_uint32_t number_mask;					
+	sk_uint8_t 	sched_class;					/* scheduling class */
+
+	/* cpu affinity */
+	sk_uint32_t cpus_allowed;					/* mask of cpus the thread may run on */
+	sk_uint8_t 	oncpu;							/* cpu the thread runs or last ran on */
 
 	/* stack point and entry */
 	void 		*sp;							/* stack point */
@@ -60,10 +146,20 @@ struct sk_thread
 	sk_ubase_t 	remain_tick;					/* remaining tick */
 	struct sk_sys_timer	thread_timer;			/* thread timer */
 
+	/* deadline scheduling */
+	struct sk_sched_edf edf;					/* parameters of EDF class */
+	struct sk_sched_fair fair;					/* parameters of fair class */
+
 	/* thread event */
 	sk_uint32_t event_set;						/* event set value */
 	sk_uint8_t  event_info;						/* event information */
 
+	/* mutex and priority inheritance */
+	struct sk_mutex *pending_mutex;				/* mutex the thread is blocked on */
+	sk_list_t 	taken_mutex_list;				/* mutexes held by the thread */
+
+	sk_err_t 	error;							/* result of last blocking wait */
+
 	void (*cleanup)(struct sk_thread *thread);	/* cleanup function when thread exit */
 	sk_ubase_t 	user_data; 						/* private user data bind this thread */
 };
@@ -80,9 +176,33 @@ struct sk_thread *sk_thread_create(const char 			*name,
 							   sk_uint32_t 			stack_size,
 							   sk_uint8_t 			priority,
 							   sk_uint32_t 			tick);
+sk_err_t sk_thread_init(struct sk_thread 	*thread,
+						const char 			*name,
+						void 				(*entry)(void *param),
+						void 				*param,
+						void 				*stack_start,
+						sk_uint32_t 		stack_size,
+						sk_uint8_t 			priority,
+						sk_uint32_t 		tick);
 void sk_thread_idle_init(void);
 sk_err_t sk_thread_resume(struct sk_thread *thread);
 sk_err_t sk_thread_suspend(struct sk_thread *thread);
+sk_err_t sk_thread_sleep(sk_tick_t tick);
+sk_err_t sk_thread_control(struct sk_thread *thread, int cmd, void *arg);
+sk_uint32_t sk_thread_stack_used(struct sk_thread *thread);
+struct sk_thread *sk_thread_edf_create(const char 		*name,
+								   void 			(*entry)(void *param),
+								   void 			*param,
+								   sk_uint32_t 		stack_size,
+								   sk_tick_t 		runtime,
+								   sk_tick_t 		deadline,
+								   sk_tick_t 		period);
+sk_err_t sk_thread_edf_wait_period(void);
+struct sk_thread *sk_thread_fair_create(const char 		*name,
+									void 			(*entry)(void *param),
+									void 			*param,
+									sk_uint32_t 		stack_size,
+									sk_uint32_t 		weight);
 
 /*
  * scheduler interfaces
@@ -92,6 +212,35 @@ void sk_system_scheduler_start(void);
 void sk_schedule_insert_thread(struct sk_thread *thread);
 void sk_schedule_remove_thread(struct sk_thread *thread);
 void sk_schedule(void);
+void sk_schedule_irq_exit(void);
+void sk_sched_lock(void);
+void sk_sched_unlock(void);
+struct sk_cpu *sk_cpu_self(void);
+
+/*
+ * multi-core interfaces
+ */
+void sk_system_smp_init(void);
+sk_uint32_t sk_cpu_online_mask(void);
+void sk_smp_send_reschedule(sk_uint32_t cpu);
+sk_err_t sk_smp_call(sk_uint32_t cpu, sk_smp_call_func_t func, void *param, sk_bool_t wait);
+sk_err_t sk_smp_call_others(sk_smp_call_func_t func, void *param, sk_bool_t wait);
+sk_uint32_t sk_smp_ipi_count(sk_uint32_t cpu, sk_uint32_t ipi);
+
+/*
+ * deadline scheduling class interfaces
+ */
+sk_bool_t sk_sched_edf_tick(struct sk_thread *thread);
+void sk_sched_edf_detach(struct sk_thread *thread);
+void sk_sched_edf_place(struct sk_thread *thread);
+sk_uint32_t sk_sched_edf_bandwidth(void);
+
+/*
+ * fair share scheduling class interfaces
+ */
+sk_bool_t sk_sched_fair_tick(struct sk_thread *thread);
+void sk_sched_fair_place(struct sk_thread *thread);
+sk_uint64_t sk_sched_fair_min_vruntime(void);
 
 
 #endif
@@ -0,0 +1,140 @@
+/*
+ *  spinlock.h
+ *  brief
+ *  	spinlock releted definitions of s-kernel. the lock word must be in
+ *  	normal cacheable memory, the mmu is enabled before any lock is taken
+ *
+ *  (C) 2025.04.28 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#ifndef __SPINLOCK_H_
+#define __SPINLOCK_H_
+
+#include <base_def.h>
+#include <config.h>
+#include <klist.h>
+#include <atomic.h>
+#include <hw.h>
+
+#define SK_SPINLOCK_TICKET_SHIFT 	16
+
+/*
+ * ticket spinlock, a cpu takes the next ticket and spins until the owner
+ * ticket comes to it, the lock is handed out in the order of arrival
+ */
+struct sk_spinlock
+{
+	union {
+		volatile sk_uint32_t slock;
+		struct {
+			volatile sk_uint16_t owner;		/* ticket being served */
+			volatile sk_uint16_t next;		/* next ticket to hand out */
+		} tickets;
+	};
+#ifdef SK_USING_SPINLOCK_STAT
+	const char 	*name;						/* name shown by the spinlock command */
+	sk_list_t 	list;						/* node in the statistics list */
+	sk_uint32_t acquire_count;				/* number of acquisitions */
+	sk_uint32_t contend_count;				/* acquisitions that had to spin */
+	sk_uint64_t spin_max;					/* longest spin, in generic counter cycles */
+	sk_uint64_t spin_total;					/* total spin time */
+#endif
+};
+typedef struct sk_spinlock sk_spinlock_t;
+
+/*
+ * spinlock interfaces
+ */
+void sk_spin_lock_init(sk_spinlock_t *lock, const char *name);
+void __sk_spin_lock_wait(sk_spinlock_t *lock, sk_uint16_t ticket);
+#ifdef SK_USING_SPINLOCK_STAT
+sk_list_t *sk_spin_lock_stat_list(void);
+#endif
+
+/*
+ * sk_spin_lock
+ * brief
+ * 		take the lock, spin with wfe while it is held by another cpu. it
+ * 		doesn't mask interrupts, see sk_spin_lock_irqsave()
+ * param
+ * 		lock: pointer to spinlock
+ */
+static inline void sk_spin_lock(sk_spinlock_t *lock)
+{
+	sk_uint32_t val;
+
+	val = sk_atomic_fetch_add32(&lock->slock, 1U << SK_SPINLOCK_TICKET_SHIFT);
+	if((sk_uint16_t)val != (sk_uint16_t)(val >> SK_SPINLOCK_TICKET_SHIFT))
+		__sk_spin_lock_wait(lock, val >> SK_SPINLOCK_TICKET_SHIFT);
+
+#ifdef SK_USING_SPINLOCK_STAT
+	lock->acquire_count++;
+#endif
+}
+
+/*
+ * sk_spin_trylock
+ * brief
+ * 		take the lock only if it is free
+ * param
+ * 		lock: pointer to spinlock
+ */
+static inline sk_bool_t sk_spin_trylock(sk_spinlock_t *lock)
+{
+	sk_uint32_t val = lock->slock;
+
+	if((sk_uint16_t)val != (sk_uint16_t)(val >> SK_SPINLOCK_TICKET_SHIFT))
+		return SK_FALSE;
+
+	if(sk_atomic_cmpxchg32_acquire(&lock->slock, val, val + (1U << SK_SPINLOCK_TICKET_SHIFT)) != val)
+		return SK_FALSE;
+
+#ifdef SK_USING_SPINLOCK_STAT
+	lock->acquire_count++;
+#endif
+
+	return SK_TRUE;
+}
+
+/*
+ * sk_spin_unlock
+ * brief
+ * 		serve the next ticket, the store wakes up the cpus waiting in wfe
+ * param
+ * 		lock: pointer to spinlock
+ */
+static inline void sk_spin_unlock(sk_spinlock_t *lock)
+{
+	sk_atomic_store16_release(&lock->tickets.owner, lock->tickets.owner + 1);
+}
+
+/*
+ * sk_spin_lock_irqsave
+ * brief
+ * 		mask interrupts of this cpu and take the lock, for data shared with
+ * 		interrupt handlers
+ * param
+ * 		lock: pointer to spinlock
+ * return
+ * 		interrupt level for sk_spin_unlock_irqrestore()
+ */
+static inline sk_base_t sk_spin_lock_irqsave(sk_spinlock_t *lock)
+{
+	sk_base_t level;
+
+	level = hw_interrupt_disable();
+	sk_spin_lock(lock);
+
+	return level;
+}
+
+static inline void sk_spin_unlock_irqrestore(sk_spinlock_t *lock, sk_base_t level)
+{
+	sk_spin_unlock(lock);
+	hw_interrupt_enable(level);
+}
+
+#endif
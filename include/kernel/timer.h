@@ -27,6 +27,9 @@
 #define SK_TIMER_CTRL_SET_PERIODIC 	(0x04)
 #define SK_TIMER_CTRL_GET_STATE 	(0x08)
 
+/* tick comparison which survives the tick counter wrapping around */
+#define SK_TICK_BEFORE(a, b) 		((sk_int32_t)((a) - (b)) < 0)
+
 /*
  * system timer structure
  */
@@ -48,6 +51,8 @@ sk_err_t sk_timer_start(struct sk_sys_timer *timer);
 sk_err_t sk_timer_stop(struct sk_sys_timer *timer);
 sk_err_t sk_timer_control(struct sk_sys_timer *timer, int cmd, void *arg);
 sk_tick_t sk_tick_from_ms(sk_uint32_t ms);
+void sk_tick_isr_time(sk_uint64_t *max, sk_uint64_t *total);
+sk_uint64_t sk_tick_isr_latency(sk_bool_t reset);
 struct sk_sys_timer* sk_timer_create(const char *name,
 									  void (timeout)(void *param),
 									  void *param,
@@ -11,9 +11,27 @@
  *  published by the Free Software Foundation.
  * */
 #include <base_def.h>
+#include <config.h>
 #include <hw.h>
+#include <sched.h>
+#include <skernel.h>
+#include <interrupt.h>
+#include <workqueue.h>
 
-volatile sk_uint8_t interrupt_nest = 0;
+/* interrupt stack of each cpu, interrupt handlers run on it */
+static sk_uint8_t sk_irq_stack[SK_CPUS_NR][SK_IRQ_STACK_SIZE] ALIGN(16);
+
+/*
+ * threaded interrupt, the handler runs in a worker thread
+ */
+struct sk_irq_thread
+{
+	struct sk_work 	 work;				/* bottom half */
+	sk_isr_handler_t handler;			/* interrupt handler, run in thread */
+	void 			 *param;			/* parameter of handler */
+	int 			 vector;			/* the interrupt number */
+	sk_uint8_t 		 prio;				/* priority of worker */
+};
 
 /*
  * This function will be called by assemly code, when enter interrupt service routine
@@ -24,10 +42,14 @@ volatile sk_uint8_t interrupt_nest = 0;
  */
 void sk_interrupt_enter(void)
 {
+	struct sk_cpu *cpu;
 	sk_base_t level;
 
 	level = hw_interrupt_disable();
-	interrupt_nest ++;
+	cpu = sk_cpu_self();
+	cpu->irq_nest ++;
+	if(cpu->irq_nest > cpu->irq_nest_max)
+		cpu->irq_nest_max = cpu->irq_nest;
 	hw_interrupt_enable(level);
 }
 
@@ -43,7 +65,7 @@ void sk_interrupt_leave(void)
 	sk_base_t level;
 
 	level = hw_interrupt_disable();
-	interrupt_nest --;
+	sk_cpu_self()->irq_nest --;
 	hw_interrupt_enable(level);
 }
 
@@ -60,7 +82,7 @@ sk_uint8_t sk_interrupt_get_nest(void)
 	sk_base_t level;
 
 	level = hw_interrupt_disable();
-	ret = interrupt_nest;
+	ret = sk_cpu_self()->irq_nest;
 	hw_interrupt_enable(level);
 
 	return ret;
@@ -68,6 +90,115 @@ sk_uint8_t sk_interrupt_get_nest(void)
 
 sk_bool_t sk_is_in_interrupt()
 {
-	return (interrupt_nest != 0);
+	return (sk_cpu_self()->irq_nest != 0);
+}
+
+
+/*
+ * sk_irq_stack_top
+ * brief
+ * 		paint the interrupt stack of current cpu and return its top. called
+ * 		by hw_context_switch_to() to move SP_EL1 from the boot stack
+ *
+ * note: don't invoke this function in application
+ */
+sk_ubase_t sk_irq_stack_top(void)
+{
+	sk_uint8_t *stack = sk_irq_stack[hw_cpu_id()];
+
+	sk_memset(stack, SK_THREAD_STACK_MAGIC & 0xFF, SK_IRQ_STACK_SIZE);
+
+	return (sk_ubase_t)(stack + SK_IRQ_STACK_SIZE);
 }
 
+/*
+ * sk_irq_stack_used
+ * brief
+ * 		return the most interrupt stack ever used on a cpu, in bytes
+ * param
+ * 		cpu: the cpu index
+ */
+sk_uint32_t sk_irq_stack_used(sk_uint32_t cpu)
+{
+	sk_uint32_t *bottom = (sk_uint32_t *)sk_irq_stack[cpu];
+	sk_uint32_t words = SK_IRQ_STACK_SIZE / sizeof(sk_uint32_t);
+	sk_uint32_t index = 0;
+
+	while(index < words && bottom[index] == SK_THREAD_STACK_MAGIC)
+		index++;
+
+	return SK_IRQ_STACK_SIZE - index * sizeof(sk_uint32_t);
+}
+
+/*
+ * __irq_thread_work
+ * brief
+ * 		bottom half of threaded interrupt, run the handler in worker thread
+ * 		and let the interrupt come again
+ */
+static void __irq_thread_work(struct sk_work *work, void *param)
+{
+	struct sk_irq_thread *desc = (struct sk_irq_thread *)param;
+
+	desc->handler(desc->vector, desc->param);
+
+	sk_hw_interrupt_umask(desc->vector);
+}
+
+/*
+ * __irq_thread_isr
+ * brief
+ * 		top half of threaded interrupt. the level interrupt stays asserted
+ * 		until the device is served, so it is masked until the bottom half
+ * 		is done. the ack is done by the trap code after return
+ */
+static void __irq_thread_isr(int vector, void *param)
+{
+	struct sk_irq_thread *desc = (struct sk_irq_thread *)param;
+
+	sk_hw_interrupt_mask(vector);
+	sk_work_submit(&(desc->work), desc->prio);
+}
+
+/*
+ * sk_hw_interrupt_install_threaded
+ * brief
+ * 		install a threaded interrupt handler. the hard irq only masks and
+ * 		acks the interrupt, the handler is called in the worker thread of
+ * 		the given priority, so it can take long and use blocking kernel api
+ * param
+ * 		vector: the interrupt number
+ * 		handler: the interrupt handler, run in thread
+ * 		param: parameter of handler
+ * 		prio: worker priority, SK_WORK_PRIO_HIGH/NORMAL/LOW
+ */
+sk_err_t sk_hw_interrupt_install_threaded(int vector, sk_isr_handler_t handler,
+										  void *param, sk_uint8_t prio)
+{
+	struct sk_irq_desc *irq_desc = sk_hw_interrupt_get_desc(vector);
+	struct sk_irq_thread *desc;
+
+	if(handler == SK_NULL || irq_desc == SK_NULL || prio >= SK_WORK_PRIO_NR)
+		return SK_EINVAL;
+
+	/* the bottom half stays with the line once allocated, also when a
+	 * plain handler is installed in between, its work may be pending */
+	desc = irq_desc->thread;
+	if(desc == SK_NULL) {
+		desc = (struct sk_irq_thread *)sk_malloc(sizeof(struct sk_irq_thread));
+		if(desc == SK_NULL)
+			return SK_ENOMEM;
+		sk_work_init(&(desc->work), __irq_thread_work, desc);
+		irq_desc->thread = desc;
+	}
+
+	desc->handler = handler;
+	desc->param = param;
+	desc->vector = vector;
+	desc->prio = prio;
+
+	sk_hw_interrupt_install(vector, __irq_thread_isr, desc);
+	irq_desc->flags |= SK_IRQ_FLAG_THREADED;
+
+	return SK_EOK;
+}
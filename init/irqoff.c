@@ -0,0 +1,175 @@
+/*
+ *  irqoff.c
+ *
+ *  brif
+ *      interrupts-off section profiler
+ *
+ *  (C) 2025.04.24 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <base_def.h>
+#include <config.h>
+#include <hw.h>
+
+#ifdef SK_USING_IRQOFF_PROFILE
+
+/* daif irq and fiq mask bits */
+#define IRQOFF_DAIF_MASK 			0xC0
+
+/*
+ * the open interrupts-off section of a cpu
+ */
+struct sk_irqoff_section
+{
+	sk_uint64_t start;
+	sk_ubase_t 	caller;
+	sk_bool_t 	active;
+};
+
+static struct sk_irqoff_section irqoff_section[SK_CPUS_NR];
+
+/* the longest sections of each cpu, in descending order */
+static struct sk_irqoff_record irqoff_record[SK_CPUS_NR][SK_IRQOFF_RECORD_NR];
+
+static inline sk_uint64_t __irqoff_counter(void)
+{
+	sk_uint64_t cnt;
+
+	__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (cnt));
+
+	return cnt;
+}
+
+/*
+ * sk_irqoff_enter
+ * brief
+ * 		called by hw_interrupt_disable() with interrupts masked. only the
+ * 		outermost disable opens a section, the nested ones are part of it
+ *
+ * note: don't invoke this function in application
+ *
+ * param
+ * 		level: daif before masking
+ * 		caller: return address of hw_interrupt_disable()
+ * return
+ * 		level, passed back to the caller of hw_interrupt_disable()
+ */
+sk_base_t sk_irqoff_enter(sk_base_t level, sk_ubase_t caller)
+{
+	struct sk_irqoff_section *section;
+
+	if(level & IRQOFF_DAIF_MASK)
+		return level;
+
+	section = &irqoff_section[hw_cpu_id()];
+	section->caller = caller;
+	section->active = SK_TRUE;
+	section->start = __irqoff_counter();
+
+	return level;
+}
+
+/*
+ * sk_irqoff_leave
+ * brief
+ * 		called by hw_interrupt_enable() before interrupts come back. the
+ * 		section may be closed by another thread after a context switch, the
+ * 		time is still interrupts-off time of the cpu
+ *
+ * note: don't invoke this function in application
+ *
+ * param
+ * 		level: daif to be restored
+ * 		caller: return address of hw_interrupt_enable()
+ */
+void sk_irqoff_leave(sk_base_t level, sk_ubase_t caller)
+{
+	struct sk_irqoff_section *section;
+	struct sk_irqoff_record *record;
+	sk_uint64_t cycles;
+	sk_ubase_t cpu;
+	sk_int32_t index;
+
+	/* interrupts stay masked, the section goes on */
+	if(level & IRQOFF_DAIF_MASK)
+		return;
+
+	cpu = hw_cpu_id();
+	section = &irqoff_section[cpu];
+	if(!section->active)
+		return;
+
+	section->active = SK_FALSE;
+	cycles = __irqoff_counter() - section->start;
+
+	record = irqoff_record[cpu];
+	if(cycles <= record[SK_IRQOFF_RECORD_NR - 1].cycles)
+		return;
+
+	/* insertion into the descending list, drop the shortest */
+	for(index = SK_IRQOFF_RECORD_NR - 1; index > 0; index--) {
+		if(record[index - 1].cycles >= cycles)
+			break;
+		record[index] = record[index - 1];
+	}
+	record[index].cycles = cycles;
+	record[index].enter_caller = section->caller;
+	record[index].leave_caller = caller;
+}
+
+/*
+ * sk_irqoff_get
+ * brief
+ * 		copy the longest interrupts-off sections of a cpu
+ * param
+ * 		cpu: the cpu index
+ * 		record: buffer of the records
+ * 		size: number of records of the buffer
+ * return
+ * 		number of records copied
+ */
+sk_uint32_t sk_irqoff_get(sk_uint32_t cpu, struct sk_irqoff_record *record, sk_uint32_t size)
+{
+	sk_uint32_t index;
+	sk_base_t level;
+
+	if(cpu >= SK_CPUS_NR)
+		return 0;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	for(index = 0; index < size && index < SK_IRQOFF_RECORD_NR; index++) {
+		if(irqoff_record[cpu][index].cycles == 0)
+			break;
+		record[index] = irqoff_record[cpu][index];
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	return index;
+}
+
+/*
+ * sk_irqoff_reset
+ * brief
+ * 		drop the records of all cpus
+ */
+void sk_irqoff_reset(void)
+{
+	sk_base_t level;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	sk_memset(irqoff_record, 0, sizeof(irqoff_record));
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+}
+
+#endif
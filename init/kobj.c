@@ -16,6 +16,7 @@
 #include <hw.h>
 #include <sched.h>
 #include <device.h>
+#include <ipc.h>
 
 /* init the sk_object double list */
 #define _OBJ_CONTAINER_LIST_INIT(c)	\
@@ -23,11 +24,13 @@
 
 static struct sk_object_info _object_container[] = {
 	{SK_OBJECT_THREAD, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_THREAD), sizeof(struct sk_thread)},
-	{SK_OBJECT_SEMAPHORE, 	_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_SEMAPHORE), 0},		/* TDO */
-	{SK_OBJECT_MUTEX, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_MUTEX), 0},		/* TDO */
-	{SK_OBJECT_EVENT, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_EVENT), 0},		/* TDO */
-	{SK_OBJECT_MAILBOX, 	_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_MAILBOX), 0},		/* TDO */
-	{SK_OBJECT_MSQUE, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_MSQUE), 0},		/* TDO */
+	{SK_OBJECT_SEMAPHORE, 	_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_SEMAPHORE), sizeof(struct sk_sem)},
+	{SK_OBJECT_MUTEX, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_MUTEX), sizeof(struct sk_mutex)},
+	{SK_OBJECT_EVENT, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_EVENT), sizeof(struct sk_event)},
+	{SK_OBJECT_MAILBOX, 	_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_MAILBOX), sizeof(struct sk_mailbox)},
+	{SK_OBJECT_MSQUE, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_MSQUE), sizeof(struct sk_msg_queue)},
+	{SK_OBJECT_RWLOCK, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_RWLOCK), sizeof(struct sk_rwlock)},
+	{SK_OBJECT_COND, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_COND), sizeof(struct sk_cond)},
 	{SK_OBJECT_DEVICE, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_DEVICE), sizeof(struct sk_device)},
 	{SK_OBJECT_TIMER, 		_OBJ_CONTAINER_LIST_INIT(SK_OBJECT_TIMER), sizeof(struct sk_sys_timer)},
 };
@@ -70,12 +73,19 @@ struct sk_object *sk_object_find(const char *name, enum sk_object_type type)
 	if(name == SK_NULL || info == SK_NULL)
 		return SK_NULL;
 
+	/* the walk may be long, keep interrupt enabled */
+	sk_sched_lock();
+
 	sk_list_for_each(node, &(info->obj_list)) {
 		obj = sk_list_entry(node, struct sk_object, list);
-		if(sk_strcmp(obj->name, name, SK_NAME_MAX) == 0)
+		if(sk_strcmp(obj->name, name, SK_NAME_MAX) == 0) {
+			sk_sched_unlock();
 			return obj;
+		}
 	}
 
+	sk_sched_unlock();
+
 	return SK_NULL;
 }
 
@@ -91,7 +101,6 @@ struct sk_object *sk_object_alloc(enum sk_object_type type, const char *name)
 {
 	struct sk_object *obj;
 	struct sk_object_info  *info;
-	sk_base_t level;
 
 	/* get object information */
 	info = sk_object_get_info(type);
@@ -110,14 +119,13 @@ struct sk_object *sk_object_alloc(enum sk_object_type type, const char *name)
 	/* copy name */
 	sk_memcpy(obj->name, name, SK_NAME_MAX);
 
-	/* disable interrupt */
-	level = hw_interrupt_disable();
+	/* object list is only changed by threads */
+	sk_sched_lock();
 
 	/* insert object into information object list */
 	sk_list_add(&(info->obj_list), &(obj->list));
 
-	/* enable interrupt */
-	hw_interrupt_enable(level);
+	sk_sched_unlock();
 
 	return obj;
 }
@@ -131,19 +139,16 @@ struct sk_object *sk_object_alloc(enum sk_object_type type, const char *name)
  */
 void sk_object_delete(struct sk_object *obj)
 {
-	sk_base_t level;
-
 	/* reset object type */
 	obj->type = -1;
 
-	/* disable interrupt */
-	level = hw_interrupt_disable();
+	/* object list is only changed by threads */
+	sk_sched_lock();
 
-	/* insert object into information object list */
+	/* remove object from information object list */
 	sk_list_del(&(obj->list));
 
-	/* enable interrupt */
-	hw_interrupt_enable(level);
+	sk_sched_unlock();
 
 	/* free the memory of object */
 	sk_free(obj);
@@ -166,14 +171,19 @@ void sk_object_init(struct sk_object *obj,
 	/* get object information */
 	info = sk_object_get_info(type);
 
+	/* the walk may be long, keep interrupt enabled */
+	sk_sched_lock();
+
 	/* try to find object */
 	for(node = info->obj_list.next; node != &(info->obj_list); 
 		node = node->next) {
 		struct sk_object *obj_tmp;
 
 		obj_tmp = sk_list_entry(node, struct sk_object, list);
-		if(obj_tmp == obj)
+		if(obj_tmp == obj) {
+			sk_sched_unlock();
 			return;
+		}
 	}
 	/* initialize object's parameters */
 	obj->type = type;
@@ -181,6 +191,8 @@ void sk_object_init(struct sk_object *obj,
 	/* insert object into information object list */
 	sk_list_add(&(info->obj_list), &(obj->list));
 
+	sk_sched_unlock();
+
 	return;
 }
 
@@ -0,0 +1,350 @@
+/*
+ *  smp.c
+ *
+ *  brif
+ *      secondary cpu bring-up and inter-processor interrupts
+ *
+ *  (C) 2025.04.26 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <base_def.h>
+#include <config.h>
+#include <hw.h>
+#include <sched.h>
+#include <skernel.h>
+#include <atomic.h>
+
+/* psci function ids, smc calling convention 64-bit */
+#define PSCI_CPU_ON 				0xC4000003
+#define PSCI_SUCCESS 				0
+
+/* time given to a secondary cpu to come online, in ms */
+#define SMP_BOOT_TIMEOUT 			100
+
+/*
+ * function call request of a target cpu. lock is held by the sender from
+ * filling the request until the target finished the call, seq counts the
+ * finished calls so that the sender can wait for its own one
+ */
+struct sk_smp_call_data
+{
+	sk_uint32_t 		lock;
+	sk_uint32_t 		pending;
+	sk_smp_call_func_t 	func;
+	void 				*param;
+	sk_uint32_t 		seq;
+};
+
+static struct sk_smp_call_data smp_call_data[SK_CPUS_NR];
+
+/* number of received ipis of each cpu */
+static sk_uint32_t smp_ipi_count[SK_CPUS_NR][SK_IPI_NR];
+
+static sk_uint32_t smp_online_mask;
+
+/* boot stack of secondary cpus, they keep running on it as idle loop */
+static sk_uint8_t smp_boot_stack[SK_CPUS_NR][SK_SMP_BOOT_STACK_SIZE] ALIGN(16);
+
+extern void secondary_entry(void);
+
+static inline sk_uint64_t __smp_counter(void)
+{
+	sk_uint64_t cnt;
+
+	__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (cnt));
+
+	return cnt;
+}
+
+/*
+ * __smp_reschedule_isr
+ * brief
+ * 		the reschedule is done by sk_schedule_irq_exit() on interrupt exit
+ */
+static void __smp_reschedule_isr(int vector, void *param)
+{
+	struct sk_cpu *cpu = sk_cpu_self();
+
+	smp_ipi_count[hw_cpu_id()][SK_IPI_RESCHEDULE]++;
+	cpu->need_resched = 1;
+	cpu->resched_request++;
+}
+
+/*
+ * __smp_call_isr
+ * brief
+ * 		run the function call request of this cpu and release it
+ */
+static void __smp_call_isr(int vector, void *param)
+{
+	sk_ubase_t cpu = hw_cpu_id();
+	struct sk_smp_call_data *call = &smp_call_data[cpu];
+
+	smp_ipi_count[cpu][SK_IPI_CALL]++;
+
+	/* a late sgi of a request already served */
+	if(!sk_atomic_load32_acquire(&call->pending))
+		return;
+
+	call->pending = 0;
+	call->func(call->param);
+
+	sk_atomic_store32_release(&call->seq, call->seq + 1);
+	sk_atomic_store32_release(&call->lock, 0);
+}
+
+/*
+ * __smp_ipi_cpu_init
+ * brief
+ * 		sgis are banked, each cpu enables its own ones
+ */
+static void __smp_ipi_cpu_init(void)
+{
+	sk_uint32_t ipi;
+
+	for(ipi = 0; ipi < SK_IPI_NR; ipi++) {
+		sk_hw_interrupt_set_priority(GIC_IRQ_START + ipi, SK_IRQ_PRIORITY_IPI);
+		sk_hw_interrupt_umask(GIC_IRQ_START + ipi);
+	}
+}
+
+/*
+ * __smp_call_send
+ * brief
+ * 		post a function call request to the target cpu and send the ipi.
+ * 		the request is claimed with interrupts disabled and the ipi is sent
+ * 		before they come back, a handler of this cpu waiting for the same
+ * 		request can not hold up the target
+ * return
+ * 		the seq the target reaches after the call
+ */
+static sk_uint32_t __smp_call_send(sk_uint32_t cpu, sk_smp_call_func_t func, void *param)
+{
+	struct sk_smp_call_data *call = &smp_call_data[cpu];
+	sk_uint32_t seq;
+	sk_base_t level;
+
+	while(1) {
+		/* disable interrupt */
+		level = hw_interrupt_disable();
+		if(sk_atomic_xchg32(&call->lock, 1) == 0)
+			break;
+		/* enable interrupt */
+		hw_interrupt_enable(level);
+	}
+
+	call->func = func;
+	call->param = param;
+	seq = call->seq + 1;
+	sk_atomic_store32_release(&call->pending, 1);
+
+	sk_hw_interrupt_send_ipi(GIC_IRQ_START + SK_IPI_CALL, 1U << cpu);
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	return seq;
+}
+
+/*
+ * __smp_call_wait
+ * brief
+ * 		wait for the target cpu to finish the call of the given seq
+ */
+static void __smp_call_wait(sk_uint32_t cpu, sk_uint32_t seq)
+{
+	while((sk_int32_t)(sk_atomic_load32_acquire(&smp_call_data[cpu].seq) - seq) < 0)
+		;
+}
+
+/*
+ * __smp_idle_loop
+ * brief
+ * 		secondary cpus run no thread, they serve the ipis only
+ */
+static void __smp_idle_loop(void)
+{
+	__asm__ volatile ("msr daifclr, #2" ::: "memory");
+
+	while(1)
+		__asm__ volatile ("wfi");
+}
+
+/*
+ * sk_secondary_cpu_start
+ * brief
+ * 		c entry of the secondary cpus, called by secondary_entry on the
+ * 		boot stack with interrupts masked
+ *
+ * note: don't invoke this function in application
+ */
+void sk_secondary_cpu_start(void)
+{
+	sk_hw_vector_init();
+	sk_hw_interrupt_cpu_init();
+	__smp_ipi_cpu_init();
+
+	sk_atomic_fetch_or32(&smp_online_mask, 1U << hw_cpu_id());
+
+	hw_cpu_enter_idle(__smp_idle_loop);
+}
+
+/*
+ * sk_system_smp_init
+ * brief
+ * 		install the ipi handlers and start the secondary cpus by psci
+ */
+void sk_system_smp_init(void)
+{
+	sk_uint64_t freq, start;
+	sk_uint32_t cpu;
+	sk_base_t ret;
+
+	sk_hw_interrupt_install(GIC_IRQ_START + SK_IPI_RESCHEDULE, __smp_reschedule_isr, SK_NULL);
+	sk_hw_interrupt_install(GIC_IRQ_START + SK_IPI_CALL, __smp_call_isr, SK_NULL);
+	__smp_ipi_cpu_init();
+
+	smp_online_mask = 1U << hw_cpu_id();
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+
+	for(cpu = 1; cpu < SK_CPUS_NR; cpu++) {
+		/* aff0 is the cpu index on the virt machine */
+		ret = hw_psci_call(PSCI_CPU_ON, cpu, (sk_ubase_t)secondary_entry,
+						   (sk_ubase_t)&smp_boot_stack[cpu][SK_SMP_BOOT_STACK_SIZE]);
+		if(ret != PSCI_SUCCESS) {
+			sk_kprintf("cpu %d start failed: %d\n", cpu, (sk_int32_t)ret);
+			continue;
+		}
+
+		start = __smp_counter();
+		while(!(sk_atomic_load32_acquire(&smp_online_mask) & (1U << cpu))) {
+			if(__smp_counter() - start > freq * SMP_BOOT_TIMEOUT / 1000) {
+				sk_kprintf("cpu %d start timeout\n", cpu);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * sk_cpu_online_mask
+ * brief
+ * 		return the mask of cpus serving ipis, bit n for cpu n
+ */
+sk_uint32_t sk_cpu_online_mask(void)
+{
+	return sk_atomic_load32_acquire(&smp_online_mask);
+}
+
+/*
+ * sk_smp_send_reschedule
+ * brief
+ * 		ask another cpu to run its scheduler on the way out of interrupt
+ * param
+ * 		cpu: the target cpu
+ */
+void sk_smp_send_reschedule(sk_uint32_t cpu)
+{
+	if(cpu >= SK_CPUS_NR || cpu == hw_cpu_id())
+		return;
+
+	if(!(sk_cpu_online_mask() & (1U << cpu)))
+		return;
+
+	sk_hw_interrupt_send_ipi(GIC_IRQ_START + SK_IPI_RESCHEDULE, 1U << cpu);
+}
+
+/*
+ * sk_smp_call
+ * brief
+ * 		run a function in interrupt context of the target cpu. a call to the
+ * 		current cpu runs directly with interrupts disabled
+ * param
+ * 		cpu: the target cpu
+ * 		func: the function to run, it must not block
+ * 		param: parameter of func
+ * 		wait: SK_TRUE to return after func finished on the target
+ */
+sk_err_t sk_smp_call(sk_uint32_t cpu, sk_smp_call_func_t func, void *param, sk_bool_t wait)
+{
+	sk_uint32_t seq;
+	sk_base_t level;
+
+	if(cpu >= SK_CPUS_NR || func == SK_NULL)
+		return SK_EINVAL;
+
+	if(!(sk_cpu_online_mask() & (1U << cpu)))
+		return SK_ERROR;
+
+	if(cpu == hw_cpu_id()) {
+		/* disable interrupt */
+		level = hw_interrupt_disable();
+		func(param);
+		/* enable interrupt */
+		hw_interrupt_enable(level);
+		return SK_EOK;
+	}
+
+	seq = __smp_call_send(cpu, func, param);
+	if(wait)
+		__smp_call_wait(cpu, seq);
+
+	return SK_EOK;
+}
+
+/*
+ * sk_smp_call_others
+ * brief
+ * 		run a function on all the other online cpus. the requests are sent
+ * 		first, then waited for together
+ * param
+ * 		func: the function to run, it must not block
+ * 		param: parameter of func
+ * 		wait: SK_TRUE to return after func finished on all the targets
+ */
+sk_err_t sk_smp_call_others(sk_smp_call_func_t func, void *param, sk_bool_t wait)
+{
+	sk_uint32_t seq[SK_CPUS_NR];
+	sk_uint32_t cpu, self, mask;
+
+	if(func == SK_NULL)
+		return SK_EINVAL;
+
+	self = hw_cpu_id();
+	mask = sk_cpu_online_mask() & ~(1U << self);
+
+	for(cpu = 0; cpu < SK_CPUS_NR; cpu++) {
+		if(mask & (1U << cpu))
+			seq[cpu] = __smp_call_send(cpu, func, param);
+	}
+
+	if(!wait)
+		return SK_EOK;
+
+	for(cpu = 0; cpu < SK_CPUS_NR; cpu++) {
+		if(mask & (1U << cpu))
+			__smp_call_wait(cpu, seq[cpu]);
+	}
+
+	return SK_EOK;
+}
+
+/*
+ * sk_smp_ipi_count
+ * brief
+ * 		return the number of ipis of a type received by a cpu
+ * param
+ * 		cpu: the cpu index
+ * 		ipi: SK_IPI_RESCHEDULE or SK_IPI_CALL
+ */
+sk_uint32_t sk_smp_ipi_count(sk_uint32_t cpu, sk_uint32_t ipi)
+{
+	if(cpu >= SK_CPUS_NR || ipi >= SK_IPI_NR)
+		return 0;
+
+	return smp_ipi_count[cpu][ipi];
+}
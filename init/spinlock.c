@@ -0,0 +1,128 @@
+/*
+ *  spinlock.c
+ *
+ *  brif
+ *      atomic feature detection and ticket spinlock
+ *
+ *  (C) 2025.04.28 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <base_def.h>
+#include <config.h>
+#include <spinlock.h>
+
+sk_bool_t sk_atomic_lse;
+
+#ifdef SK_USING_SPINLOCK_STAT
+/* locks with statistics, the list is protected by a lock without them */
+static sk_list_t spin_stat_list = {&spin_stat_list, &spin_stat_list};
+static sk_spinlock_t spin_stat_lock;
+
+static inline sk_uint64_t __spin_counter(void)
+{
+	sk_uint64_t cnt;
+
+	__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (cnt));
+
+	return cnt;
+}
+#endif
+
+/*
+ * sk_atomic_init
+ * brief
+ * 		select the lse atomic instructions if the cpu implements them,
+ * 		exclusive load/store is used until then
+ */
+void sk_atomic_init(void)
+{
+	sk_uint64_t isar0;
+
+	__asm__ volatile ("mrs %0, ID_AA64ISAR0_EL1" : "=r" (isar0));
+
+	/* atomic field [23:20] is 0b0010 with the lse instructions */
+	sk_atomic_lse = ((isar0 >> 20) & 0xF) >= 2;
+}
+
+/*
+ * sk_spin_lock_init
+ * brief
+ * 		initialize a spinlock to the unlocked state
+ * param
+ * 		lock: pointer to spinlock
+ * 		name: name of the lock in the statistics
+ */
+void sk_spin_lock_init(sk_spinlock_t *lock, const char *name)
+{
+	lock->slock = 0;
+
+#ifdef SK_USING_SPINLOCK_STAT
+	lock->name = name;
+	lock->acquire_count = 0;
+	lock->contend_count = 0;
+	lock->spin_max = 0;
+	lock->spin_total = 0;
+
+	sk_spin_lock(&spin_stat_lock);
+	sk_list_add_tail(&spin_stat_list, &(lock->list));
+	sk_spin_unlock(&spin_stat_lock);
+#else
+	(void)name;
+#endif
+}
+
+/*
+ * __sk_spin_lock_wait
+ * brief
+ * 		wait for the ticket to be served. the exclusive load arms the monitor
+ * 		of the owner ticket, the unlock store wakes this cpu from wfe
+ *
+ * note: don't invoke this function in application
+ *
+ * param
+ * 		lock: pointer to spinlock
+ * 		ticket: the ticket taken by sk_spin_lock()
+ */
+void __sk_spin_lock_wait(sk_spinlock_t *lock, sk_uint16_t ticket)
+{
+	sk_uint32_t tmp;
+#ifdef SK_USING_SPINLOCK_STAT
+	sk_uint64_t start, cycles;
+
+	start = __spin_counter();
+#endif
+
+	__asm__ volatile (
+	"	sevl\n"
+	"1:	wfe\n"
+	"	ldaxrh 	%w0, %1\n"
+	"	eor 	%w0, %w0, %w2\n"
+	"	cbnz 	%w0, 1b\n"
+	: "=&r" (tmp)
+	: "Q" (lock->tickets.owner), "r" ((sk_uint32_t)ticket)
+	: "memory");
+
+#ifdef SK_USING_SPINLOCK_STAT
+	/* the lock is held, statistics are updated under it */
+	cycles = __spin_counter() - start;
+	lock->contend_count++;
+	lock->spin_total += cycles;
+	if(cycles > lock->spin_max)
+		lock->spin_max = cycles;
+#endif
+}
+
+#ifdef SK_USING_SPINLOCK_STAT
+/*
+ * sk_spin_lock_stat_list
+ * brief
+ * 		return the list of locks with statistics, linked by sk_spinlock.list
+ */
+sk_list_t *sk_spin_lock_stat_list(void)
+{
+	return &spin_stat_list;
+}
+#endif
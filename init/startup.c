@@ -16,6 +16,9 @@
 #include <sched.h>
 #include <board.h>
 #include <shell.h>
+#include <workqueue.h>
+#include <atomic.h>
+#include <mmu.h>
 
 extern unsigned char __bss_start;
 extern unsigned char __bss_end;
@@ -26,6 +29,10 @@ extern unsigned char __bss_end;
 #define SK_MAIN_THREAD_STATCK_SIZE 		(2048)
 #define SK_MAIN_THREAD_PRIORITY 		(SK_THREAD_PRIORITY_MAX/3)
 
+/* main thread is placed statically */
+static struct sk_thread main_thread;
+static sk_uint8_t main_thread_stack[SK_MAIN_THREAD_STATCK_SIZE] ALIGN(16);
+
 /*
  * Init the hardware related 
  *
@@ -35,14 +42,21 @@ void sk_hw_board_init(void)
 {
     hw_interrupt_disable();
 
+	/* exclusive load/store needs normal cacheable memory, mmu goes first */
+	mmu_init();
+	mmu_enable();
+
+	/* select the atomic instructions before any lock is taken */
+	sk_atomic_init();
+
+	/* memory management init, the interrupt table is allocated */
+	sk_system_mem_init(SK_HEAP_BEGIN, SK_HEAP_END);
+
 	/* Initialize hardware interrupt */
 	sk_hw_interrupt_init();
 
 	/* kernel tick init */
 	sk_hw_timer_init();
-
-	/* memory management init */
-	sk_system_mem_init(SK_HEAP_BEGIN, SK_HEAP_END);
 }
 
 /*
@@ -70,13 +84,15 @@ void sk_application_init(void)
 	extern void main(void *); 
 	char user_thread_name[SK_NAME_MAX] = "main";
 
-	struct sk_thread *thread = sk_thread_create(user_thread_name,
-												main,
-												SK_NULL,
-												SK_MAIN_THREAD_STATCK_SIZE,
-												SK_MAIN_THREAD_PRIORITY,
-												20);
-	sk_thread_startup(thread);
+	sk_thread_init(&main_thread,
+				   user_thread_name,
+				   main,
+				   SK_NULL,
+				   main_thread_stack,
+				   SK_MAIN_THREAD_STATCK_SIZE,
+				   SK_MAIN_THREAD_PRIORITY,
+				   20);
+	sk_thread_startup(&main_thread);
 }
 
 int skernel_startup(void)
@@ -89,6 +105,10 @@ int skernel_startup(void)
 	sk_system_timer_init();
 	/* scheduler system init */
 	sk_system_scheduler_init();
+	/* ipi init and secondary cpus start */
+	sk_system_smp_init();
+	/* work queue init, worker threads serve the threaded interrupts */
+	sk_workqueue_system_init();
 	/* system component init */
 	sk_system_component_init();
 	/* user main thread init */
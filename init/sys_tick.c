@@ -22,7 +22,12 @@ static sk_uint64_t timer_step;
 static volatile sk_tick_t sk_tick = 0;
 
 static sk_list_t __timer_list;
-sk_bool_t need_schedule = SK_FALSE;
+
+/* time spent in tick isr, in counter cycles */
+static sk_uint64_t tick_isr_time_max;
+static sk_uint64_t tick_isr_time_total;
+/* delay from timer firing to tick isr entry, in counter cycles */
+static sk_uint64_t tick_isr_latency_max;
 
 /*
  * This function will be called by timer isr
@@ -131,16 +136,16 @@ sk_err_t sk_timer_delete(struct sk_sys_timer *timer)
 {
 	sk_ubase_t level;
 
-	/* disabled interrupt */
-	level = hw_interrupt_disable();
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
 
 	__timer_remove(timer);
 	
 	/* stop timer */
 	timer->parent.flag &= ~SK_TIMER_FLAG_ACTIVE;
 
-	/* enable interrupt */
-	hw_interrupt_enable(level);
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
 
 	sk_object_delete(&(timer->parent));
 
@@ -169,8 +174,8 @@ sk_err_t sk_timer_start(struct sk_sys_timer *timer)
 	sk_base_t level;
 	sk_bool_t need_sched = SK_FALSE;
 
-	/* disable interrupt */
-	level = hw_interrupt_disable();
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
 
 	/* remove timer from list */
 	__timer_remove(timer);
@@ -181,8 +186,8 @@ sk_err_t sk_timer_start(struct sk_sys_timer *timer)
 
 	/* add timer list to __timer_list */
 	sk_list_add(&__timer_list, &(timer->list));
-	/* enable interrupt */
-	hw_interrupt_enable(level);
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
 
 	return SK_EOK;
 }
@@ -202,8 +207,8 @@ sk_err_t sk_timer_stop(struct sk_sys_timer *timer)
 	if(!(timer->parent.flag & SK_TIMER_FLAG_ACTIVE))
 		return SK_ERROR;
 
-	/* disable interrupt */
-	level = hw_interrupt_disable();
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
 
 	/* change status of timer */
 	timer->parent.flag &= ~SK_TIMER_FLAG_ACTIVE; 
@@ -211,8 +216,8 @@ sk_err_t sk_timer_stop(struct sk_sys_timer *timer)
 	/* remove timer from list */
 	__timer_remove(timer);
 
-	/* enable interrupt */
-	hw_interrupt_enable(level);
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
 
 	return SK_EOK;
 }
@@ -230,21 +235,26 @@ sk_err_t sk_timer_control(struct sk_sys_timer *timer, int cmd, void *arg)
 {
 	sk_base_t level;
 
-	/* disable interrupt */
-	level = hw_interrupt_disable();
-
 	switch(cmd) {
 		case SK_TIMER_CTRL_GET_TIME:
-			*(sk_tick_t *)arg = timer->init_tick;
-		break;
 		case SK_TIMER_CTRL_SET_TIME:
-			timer->init_tick = *(sk_tick_t *)arg;
+			/* init_tick is also changed by the deadline class in tick isr */
+			level = hw_interrupt_mask_kernel();
+			if(cmd == SK_TIMER_CTRL_GET_TIME)
+				*(sk_tick_t *)arg = timer->init_tick;
+			else
+				timer->init_tick = *(sk_tick_t *)arg;
+			hw_interrupt_unmask_kernel(level);
 		break;
 		case SK_TIMER_CTRL_SET_ONSHOT:
-			timer->parent.flag &= ~SK_TIMER_FLAG_PERIODIC;
-		break;
 		case SK_TIMER_CTRL_SET_PERIODIC:
-			timer->parent.flag |= SK_TIMER_FLAG_PERIODIC;
+			/* flag is also changed by sk_timer_check() in tick isr */
+			level = hw_interrupt_mask_kernel();
+			if(cmd == SK_TIMER_CTRL_SET_ONSHOT)
+				timer->parent.flag &= ~SK_TIMER_FLAG_PERIODIC;
+			else
+				timer->parent.flag |= SK_TIMER_FLAG_PERIODIC;
+			hw_interrupt_unmask_kernel(level);
 		break;
 		case SK_TIMER_CTRL_GET_STATE:
 			if(timer->parent.flag & SK_TIMER_FLAG_ACTIVE)
@@ -256,9 +266,6 @@ sk_err_t sk_timer_control(struct sk_sys_timer *timer, int cmd, void *arg)
 		break;
 	}
 
-	/* enable interrupt */
-	hw_interrupt_enable(level);
-
 	return SK_EOK;
 }
 
@@ -325,6 +332,7 @@ void sk_tick_increase(void)
 {
 	struct sk_thread *thread;
 	sk_base_t level;
+	sk_bool_t need_sched = SK_FALSE;
 
 	/* disable interrupt */
 	level = hw_interrupt_disable();
@@ -334,23 +342,31 @@ void sk_tick_increase(void)
 
 	/* check time slice */
 	thread = sk_current_thread();
-	/* update current threac remain tick */
-	--thread->remain_tick;
-	/* if current thread tick is over, schedule */
-	if(thread->remain_tick == 0) {
-		/* change to initialized tick */
-		thread->remain_tick = thread->init_tick;
-		thread->stat |= SK_THREAD_YIELD;
-		/* enable interrupt */
-		hw_interrupt_enable(level);
-		/* schedule next ready thread */
-		need_schedule = SK_TRUE;
-		sk_schedule();
+	if(thread->sched_class == SK_SCHED_CLASS_EDF) {
+		/* deadline thread consumes its budget instead of time slice */
+		need_sched = sk_sched_edf_tick(thread);
+	} else if(thread->sched_class == SK_SCHED_CLASS_FAIR) {
+		/* fair thread is charged weighted virtual runtime */
+		need_sched = sk_sched_fair_tick(thread);
 	} else {
-		/* enable interrupt */
-		hw_interrupt_enable(level);
+		/* update current threac remain tick */
+		--thread->remain_tick;
+		/* if current thread tick is over, schedule */
+		if(thread->remain_tick == 0) {
+			/* change to initialized tick */
+			thread->remain_tick = thread->init_tick;
+			thread->stat |= SK_THREAD_YIELD;
+			need_sched = SK_TRUE;
+		}
 	}
 
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	/* schedule next ready thread */
+	if(need_sched)
+		sk_schedule();
+
 	/* check the system timer list, if timeout ,then call timeout function of timer */
 	sk_timer_check();
 }
@@ -379,11 +395,73 @@ sk_tick_t sk_tick_from_ms(sk_uint32_t ms)
  */
 void sk_hw_timer_isr(int vector, void *param)
 {
+	sk_uint64_t start, end;
+
+	__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (start));
+
+	/* timer_val is the compare value which fired this interrupt */
+	if(start - timer_val > tick_isr_latency_max)
+		tick_isr_latency_max = start - timer_val;
+	sk_hw_interrupt_record_latency(vector, start - timer_val);
+
 	timer_val += timer_step;
 	__asm__ volatile ("msr CNTV_CVAL_EL0, %0"::"r"(timer_val));
 	__asm__ volatile ("isb":::"memory");
 	
 	sk_tick_increase();
+
+	__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (end));
+	tick_isr_time_total += end - start;
+	if(end - start > tick_isr_time_max)
+		tick_isr_time_max = end - start;
+}
+
+/*
+ * sk_tick_isr_time
+ * brief
+ * 		get the time spent in tick isr, in counter cycles
+ * param
+ * 		max: the longest tick isr
+ * 		total: sum of all tick isr
+ */
+void sk_tick_isr_time(sk_uint64_t *max, sk_uint64_t *total)
+{
+	sk_base_t level;
+
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
+
+	*max = tick_isr_time_max;
+	*total = tick_isr_time_total;
+
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
+}
+
+/*
+ * sk_tick_isr_latency
+ * brief
+ * 		get the worst delay from timer firing to tick isr entry, in counter
+ * 		cycles. it is mostly the longest interrupt masked section
+ * param
+ * 		reset: restart the measurement
+ */
+sk_uint64_t sk_tick_isr_latency(sk_bool_t reset)
+{
+	sk_base_t level;
+	sk_uint64_t latency;
+
+	/* mask kernel interrupts */
+	level = hw_interrupt_mask_kernel();
+
+	latency = tick_isr_latency_max;
+	if(reset)
+		tick_isr_latency_max = 0;
+
+	/* unmask kernel interrupts */
+	hw_interrupt_unmask_kernel(level);
+
+	return latency;
 }
 
 /*
@@ -394,6 +472,7 @@ void sk_hw_timer_isr(int vector, void *param)
 int sk_hw_timer_init(void)
 {
 	sk_hw_interrupt_install(HW_TIMER_VECTOR_NUM, sk_hw_timer_isr, SK_NULL);
+	sk_hw_interrupt_set_priority(HW_TIMER_VECTOR_NUM, SK_IRQ_PRIORITY_TICK);
 	sk_hw_interrupt_umask(HW_TIMER_VECTOR_NUM);
 
 	__asm__ volatile ("msr CNTV_CTL_EL0, %0"::"r"(0));
@@ -0,0 +1,271 @@
+/*
+ *  cond.c
+ *  brief
+ *  	condition variable module of ipc
+ *
+ *  (C) 2025.04.29 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <ipc.h>
+#include <atomic.h>
+
+extern sk_err_t __ipc_list_resume_all(sk_list_t *list);
+extern sk_err_t __ipc_object_init(struct sk_ipc_object *ipc);
+extern sk_err_t __ipc_list_suspend(sk_list_t *list,
+									  struct sk_thread *thread,
+									  sk_uint8_t flag);
+extern sk_bool_t __mutex_requeue(struct sk_mutex *mutex, struct sk_thread *thread);
+
+/*
+ * __cond_wake
+ * brief
+ * 		wake up the first waiter. it is not resumed to contend for the mutex,
+ * 		it is moved to the mutex and runs once it is the owner. called with
+ * 		interrupt disabled
+ * param
+ * 		cond: pointer to condition variable
+ * return
+ * 		SK_TRUE if the waiter has been resumed
+ */
+static sk_bool_t __cond_wake(struct sk_cond *cond)
+{
+	struct sk_thread *thread;
+
+	thread = sk_list_entry(cond->parent.suspend_thread.next, struct sk_thread, tlist);
+
+	/* signaled, the time out period is over */
+	sk_timer_stop(&(thread->thread_timer));
+
+	if(__mutex_requeue(cond->mutex, thread)) {
+		sk_thread_resume(thread);
+		return SK_TRUE;
+	}
+
+	return SK_FALSE;
+}
+
+/*
+ * sk_cond_init
+ * brief
+ * 		this function will init a condition variable object
+ * param
+ * 		cond: pointer to condition variable
+ * 		name: the name of condition variable
+ * 		flag: order of waiting threads, SK_IPC_FLAG_FIFO or SK_IPC_FLAG_PRIO
+ */
+sk_err_t sk_cond_init(struct sk_cond *cond, const char *name, sk_uint8_t flag)
+{
+	/* initialize object */
+	sk_object_init(&(cond->parent.parent), SK_OBJECT_COND, name);
+
+	/* initialize ipc object */
+	__ipc_object_init(&(cond->parent));
+
+	cond->mutex = SK_NULL;
+	cond->parent.parent.flag = flag;
+
+	return SK_EOK;
+}
+
+/*
+ * sk_cond_create
+ * brief
+ * 		this function will create a condition variable object
+ * param
+ * 		name: the name of condition variable
+ * 		flag: order of waiting threads, SK_IPC_FLAG_FIFO or SK_IPC_FLAG_PRIO
+ */
+struct sk_cond *sk_cond_create(const char *name, sk_uint8_t flag)
+{
+	struct sk_cond *cond;
+
+	/* allocate object */
+	cond = (struct sk_cond *)sk_object_alloc(SK_OBJECT_COND, name);
+	if(cond == SK_NULL)
+		return cond;
+
+	/* initialize ipc object */
+	__ipc_object_init(&(cond->parent));
+
+	cond->mutex = SK_NULL;
+	cond->parent.parent.flag = flag;
+
+	return cond;
+}
+
+/*
+ * sk_cond_delete
+ * brief
+ * 		delete a condition variable object which is created by the
+ * 		sk_cond_create function
+ * param
+ * 		cond: pointer to condition variable object to be deleted
+ */
+sk_err_t sk_cond_delete(struct sk_cond *cond)
+{
+	sk_list_t *n;
+	struct sk_thread *thread;
+	sk_ubase_t temp;
+
+	if(cond == SK_NULL)
+		return SK_EOK;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* waiting threads take the mutex again and return with error */
+	sk_list_for_each(n, &(cond->parent.suspend_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	/* wakeup all syspended threads */
+	__ipc_list_resume_all(&(cond->parent.suspend_thread));
+
+	/* delete condition variable object */
+	sk_object_delete(&(cond->parent.parent));
+
+	return SK_EOK;
+}
+
+/*
+ * sk_cond_wait
+ * brief
+ * 		this function will release the mutex and wait for the condition
+ * 		variable up to specified time, as one step. the mutex is held again
+ * 		when returning, also on timeout. all waiters of a condition variable
+ * 		must use the same mutex
+ * param
+ * 		cond: pointer to condition variable
+ * 		mutex: the mutex held by current thread
+ * 		time: time out period
+ */
+sk_err_t sk_cond_wait(struct sk_cond *cond, struct sk_mutex *mutex, sk_int32_t time)
+{
+	struct sk_thread *thread;
+	sk_uint8_t hold;
+	sk_err_t err;
+	sk_ubase_t temp;
+
+	/* get current thread */
+	thread = sk_current_thread();
+
+	/* mutex only can be released by owner */
+	if((sk_atomic_load64_acquire(&mutex->owner) & ~SK_MUTEX_CONTENDED) != (sk_uint64_t)thread)
+		return SK_ERROR;
+
+	/* no waiting, return with timeout */
+	if(time == 0)
+		return SK_ETIMEOUT;
+
+	/* no thread switch until the mutex is released */
+	sk_sched_lock();
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	if(cond->mutex != mutex && !sk_list_empty(&(cond->parent.suspend_thread))) {
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+		sk_sched_unlock();
+
+		return SK_EINVAL;
+	}
+	cond->mutex = mutex;
+
+	/* suspend current thread */
+	thread->error = SK_EOK;
+	__ipc_list_suspend(&(cond->parent.suspend_thread), thread, cond->parent.parent.flag);
+
+	if(time > 0) {
+		/* reset the timeout thread timer and start it */
+		sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &time);
+		sk_timer_start(&(thread->thread_timer));
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	/* release the mutex whatever its hold count */
+	hold = mutex->hold;
+	mutex->hold = 1;
+	sk_mutex_unlock(mutex);
+
+	sk_sched_unlock();
+
+	/* do schedule */
+	sk_schedule();
+
+	/* woken up by signal, the mutex has been handed over */
+	err = thread->error;
+	if(err != SK_EOK)
+		sk_mutex_lock(mutex, -1);
+
+	mutex->hold = hold;
+
+	return err;
+}
+
+/*
+ * sk_cond_signal
+ * brief
+ * 		this function will wake up a thread waiting for the condition variable
+ * param
+ * 		cond: pointer to condition variable
+ */
+sk_err_t sk_cond_signal(struct sk_cond *cond)
+{
+	sk_bool_t woken = SK_FALSE;
+	sk_ubase_t temp;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	if(!sk_list_empty(&(cond->parent.suspend_thread)))
+		woken = __cond_wake(cond);
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	if(woken)
+		sk_schedule();
+
+	return SK_EOK;
+}
+
+/*
+ * sk_cond_broadcast
+ * brief
+ * 		this function will wake up all threads waiting for the condition
+ * 		variable. at most one of them takes the mutex at once, the others
+ * 		are moved to the mutex and run one by one as it is released
+ * param
+ * 		cond: pointer to condition variable
+ */
+sk_err_t sk_cond_broadcast(struct sk_cond *cond)
+{
+	sk_bool_t woken = SK_FALSE;
+	sk_ubase_t temp;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	while(!sk_list_empty(&(cond->parent.suspend_thread))) {
+		if(__cond_wake(cond))
+			woken = SK_TRUE;
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	if(woken)
+		sk_schedule();
+
+	return SK_EOK;
+}
@@ -10,6 +10,7 @@
  *  published by the Free Software Foundation.
  * */
 #include <ipc.h>
+#include <skernel.h>
 	
 
 
@@ -55,21 +56,18 @@ sk_err_t __ipc_list_resume_all(sk_list_t *list)
 }
 
 /*
- * __ipc_list_suspend
+ * __ipc_list_insert
  * brief 
- * 		this function will suspend a thread to a IPC object list
+ * 		this function will insert a suspended thread to a IPC object list
  * param
  * 		list: pointer to a suspended thread list of IPC object
- * 		thread: thread object to be suspended
- * 		flag: flag for thread object to be suspended
+ * 		thread: thread object to be inserted
+ * 		flag: flag for thread object to be inserted
  */
-sk_err_t __ipc_list_suspend(sk_list_t *list, 
+sk_err_t __ipc_list_insert(sk_list_t *list, 
 									  struct sk_thread *thread,
 									  sk_uint8_t flag)
 {
-	/* suspend thread */
-	sk_thread_suspend(thread);
-
 	switch(flag) {
 		case SK_IPC_FLAG_FIFO:
 			sk_list_add_tail(list, &(thread->tlist));
@@ -100,3 +98,107 @@ sk_err_t __ipc_list_suspend(sk_list_t *list,
 	return SK_EOK;
 }
 
+/*
+ * __ipc_list_suspend
+ * brief 
+ * 		this function will suspend a thread to a IPC object list
+ * param
+ * 		list: pointer to a suspended thread list of IPC object
+ * 		thread: thread object to be suspended
+ * 		flag: flag for thread object to be suspended
+ */
+sk_err_t __ipc_list_suspend(sk_list_t *list, 
+									  struct sk_thread *thread,
+									  sk_uint8_t flag)
+{
+	/* suspend thread */
+	sk_thread_suspend(thread);
+
+	return __ipc_list_insert(list, thread, flag);
+}
+
+/*
+ * __ipc_list_wait
+ * brief
+ * 		this function will suspend current thread to a IPC object list until
+ * 		it is woken up or times out. called with interrupt disabled, it
+ * 		returns with interrupt disabled and *timeout reduced by the ticks
+ * 		waited, the caller checks its condition again
+ * param
+ * 		list: pointer to a suspended thread list of IPC object
+ * 		flag: flag for thread object to be suspended
+ * 		timeout: remaining timeout period
+ * 		level: interrupt level saved by the caller
+ */
+sk_err_t __ipc_list_wait(sk_list_t *list, sk_uint8_t flag,
+						 sk_int32_t *timeout, sk_ubase_t *level)
+{
+	struct sk_thread *thread;
+	sk_tick_t tick = 0;
+
+	/* get current thread */
+	thread = sk_current_thread();
+
+	/* suspend current thread */
+	thread->error = SK_EOK;
+	__ipc_list_suspend(list, thread, flag);
+
+	/* has waiting time, start thread timer */
+	if(*timeout > 0) {
+		tick = sk_tick_get();
+		/* reset the timeout of thread timer and start it */
+		sk_timer_control(&(thread->thread_timer),
+						 SK_TIMER_CTRL_SET_TIME,
+						 timeout);
+		sk_timer_start(&(thread->thread_timer));
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(*level);
+
+	/* do schedule */
+	sk_schedule();
+
+	/* disable interrupt */
+	*level = hw_interrupt_disable();
+
+	if(thread->error != SK_EOK)
+		return thread->error;
+
+	/* woken up, another thread may be faster, wait the rest of time */
+	if(*timeout > 0) {
+		*timeout -= sk_tick_get() - tick;
+		if(*timeout < 0)
+			*timeout = 0;
+	}
+
+	return SK_EOK;
+}
+
+/*
+ * __ipc_list_resume_n
+ * brief
+ * 		this function will resume up to n threads of a IPC object list.
+ * 		called with interrupt disabled, the caller does the schedule
+ * param
+ * 		list: pointer to a suspended thread list of IPC object
+ * 		n: maximum number of threads to be resumed
+ * return
+ * 		number of threads resumed
+ */
+sk_uint32_t __ipc_list_resume_n(sk_list_t *list, sk_uint32_t n)
+{
+	struct sk_thread *thread;
+	sk_uint32_t count = 0;
+
+	while(count < n && !sk_list_empty(list)) {
+		/* get next suspended thread */
+		thread = sk_list_entry(list->next, struct sk_thread, tlist);
+
+		/* resume thread */
+		sk_thread_resume(thread);
+		count++;
+	}
+
+	return count;
+}
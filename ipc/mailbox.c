@@ -14,9 +14,132 @@
 
 extern sk_err_t __ipc_list_resume_all(sk_list_t *list);
 extern sk_err_t __ipc_object_init(struct sk_ipc_object *ipc);
-extern sk_err_t __ipc_list_suspend(sk_list_t *list, 
-									  struct sk_thread *thread,
-									  sk_uint8_t flag);
+extern sk_err_t __ipc_list_wait(sk_list_t *list, sk_uint8_t flag,
+								sk_int32_t *timeout, sk_ubase_t *level);
+extern sk_uint32_t __ipc_list_resume_n(sk_list_t *list, sk_uint32_t n);
+
+/*
+ * __mailbox_put
+ * brief
+ * 		put up to count mails to the mailbox in one critical section and
+ * 		wake up the receivers once, wait for a free entry up to specified time
+ * param
+ * 		mb: pointer to mailbox
+ * 		value: the mails
+ * 		count: maximum number of mails
+ * 		timeout: timeout period
+ * return
+ * 		number of mails sent, or a negative error code
+ */
+static sk_int32_t __mailbox_put(struct sk_mailbox *mb, const sk_ubase_t *value,
+								sk_size_t count, sk_int32_t timeout)
+{
+	sk_int32_t sent;
+	sk_uint32_t woken;
+	sk_ubase_t temp;
+	sk_err_t err;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* mailbox is full */
+	while(mb->entry == mb->size) {
+		/* for non-blocking call */
+		if(timeout == 0) {
+			hw_interrupt_enable(temp);
+			return SK_EFULL;
+		}
+
+		err = __ipc_list_wait(&(mb->suspend_sender_thread), mb->parent.parent.flag,
+							  &timeout, &temp);
+		if(err != SK_EOK) {
+			hw_interrupt_enable(temp);
+			return err;
+		}
+	}
+
+	/* set ptr */
+	for(sent = 0; sent < count && mb->entry < mb->size; sent++) {
+		mb->msg_pool[mb->in_offset] = value[sent];
+		++mb->in_offset;
+		if(mb->in_offset >= mb->size)
+			mb->in_offset = 0;
+		mb->entry++;
+	}
+
+	/* resume suspended receivers */
+	woken = __ipc_list_resume_n(&(mb->parent.suspend_thread), sent);
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	if(woken)
+		sk_schedule();
+
+	return sent;
+}
+
+/*
+ * __mailbox_get
+ * brief
+ * 		get up to count mails from the mailbox in one critical section and
+ * 		wake up the senders once, wait for a mail up to specified time
+ * param
+ * 		mb: pointer to mailbox
+ * 		value: buffer of the mails
+ * 		count: maximum number of mails
+ * 		timeout: timeout period
+ * return
+ * 		number of mails received, or a negative error code
+ */
+static sk_int32_t __mailbox_get(struct sk_mailbox *mb, sk_ubase_t *value,
+								sk_size_t count, sk_int32_t timeout)
+{
+	sk_int32_t received;
+	sk_uint32_t woken;
+	sk_ubase_t temp;
+	sk_err_t err;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* mailbox is empty */
+	while(mb->entry == 0) {
+		/* for non-blocking call */
+		if(timeout == 0) {
+			hw_interrupt_enable(temp);
+			return SK_ETIMEOUT;
+		}
+
+		err = __ipc_list_wait(&(mb->parent.suspend_thread), mb->parent.parent.flag,
+							  &timeout, &temp);
+		if(err != SK_EOK) {
+			hw_interrupt_enable(temp);
+			return err;
+		}
+	}
+
+	/* get mails */
+	for(received = 0; received < count && mb->entry > 0; received++) {
+		value[received] = mb->msg_pool[mb->out_offset];
+		/* increase output offset */
+		++mb->out_offset;
+		if(mb->out_offset >= mb->size)
+			mb->out_offset = 0;
+		mb->entry--;
+	}
+
+	/* resume suspended senders */
+	woken = __ipc_list_resume_n(&(mb->suspend_sender_thread), received);
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	if(woken)
+		sk_schedule();
+
+	return received;
+}
 
 /*
  * sk_mailbox_create
@@ -44,7 +167,7 @@ struct sk_mailbox *sk_mailbox_create(const char *name, sk_size_t size, sk_uint8_
 
 	mb->size = size;
 	mb->msg_pool = (sk_ubase_t *)sk_malloc(mb->size * sizeof(sk_ubase_t)); 
-	if(mb->msg_pool) {
+	if(mb->msg_pool == SK_NULL) {
 		/* delete mailbox object */
 		sk_object_delete(&(mb->parent.parent));
 
@@ -104,9 +227,29 @@ sk_err_t sk_mailbox_init(struct sk_mailbox *mb, const char *name,
  */
 sk_err_t sk_mailbox_delete(struct sk_mailbox *mb)
 {
+	sk_list_t *n;
+	struct sk_thread *thread;
+	sk_ubase_t temp;
+
 	if(mb == SK_NULL)
 		return SK_EOK;
 
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* waiting threads return with error */
+	sk_list_for_each(n, &(mb->parent.suspend_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+	sk_list_for_each(n, &(mb->suspend_sender_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
 	/* wakeup all syspended threads */
 	__ipc_list_resume_all(&(mb->parent.suspend_thread));
 
@@ -137,79 +280,11 @@ sk_err_t sk_mailbox_send_wait(struct sk_mailbox *mb,
 						 sk_ubase_t value,
 						 sk_int32_t timeout)
 {
-	struct sk_thread *thread;
-	sk_ubase_t temp;
-
-	/* get current thread */
-	thread = sk_current_thread();
-
-	/* disable interrupt */
-	temp = hw_interrupt_disable();
-
-	/* for non-blocking call */
-	if(mb->entry == mb->size && timeout == 0) {
-		hw_interrupt_enable(temp);
-		return SK_EFULL;
-	}
-
-	/* mailbox is full */
-	if(mb->entry == mb->size) {
-		/* suspend current thread */
-		__ipc_list_suspend(&(mb->suspend_sender_thread),
-						   thread,
-						   mb->parent.parent.flag);
-		/* has waiting time, start thread timer */
-		if(timeout > 0) {
-			/* reset the timeout of thread timer and start it */
-			sk_timer_control(&(thread->thread_timer),
-							 SK_TIMER_CTRL_SET_TIME,
-							 &timeout);
-			sk_timer_start(&(thread->thread_timer));
-		}
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
-	}
-
-	/* thread timer timeout and thread rerun, check mailbox is full */
-	if(mb->entry == mb->size) 
-		return SK_EFULL;
-
-	/* set ptr */
-	mb->msg_pool[mb->in_offset] = value;
-	++mb->in_offset;
-	if(mb->in_offset >= mb->size)
-		mb->in_offset = 0;
-	if(mb->entry < mb->size){
-		mb->entry++;
-	} else{
-		hw_interrupt_enable(temp);
-		return SK_EFULL;
-	}
-	/* resume suspended thread */
-	if(!sk_list_empty(&mb->parent.suspend_thread)){
-		/* get suspended thread */
-		thread = sk_list_entry(mb->parent.suspend_thread.next, 
-							   struct sk_thread,
-							   tlist); 
-		/* resume thread */
-		sk_thread_resume(thread);
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
+	sk_int32_t sent;
 
-		return SK_EOK;
-	}
-	/* enable interrupt */
-	hw_interrupt_enable(temp);
+	sent = __mailbox_put(mb, &value, 1, timeout);
 
-	return SK_EOK;
+	return sent < 0 ? sent : SK_EOK;
 }
 
 /*
@@ -238,82 +313,56 @@ sk_err_t sk_mailbox_send(struct sk_mailbox *mb, sk_ubase_t value)
  */
 sk_err_t sk_mailbox_recv(struct sk_mailbox *mb, sk_ubase_t *value, sk_int32_t timeout)
 {
-	struct sk_thread *thread;
-	sk_ubase_t temp;
-
-	/* get current thread */
-	thread = sk_current_thread();
-
-	/* disable interrupt */
-	temp = hw_interrupt_disable();
-
-	/* for non-blocking call */
-	if(mb->entry == 0 && timeout == 0) {
-		hw_interrupt_enable(temp);
-		return SK_ETIMEOUT;
-	}
+	sk_int32_t received;
 
-	/* mailbox is empty */
-	if(mb->entry == 0){
-		/* suspend current thread */
-		__ipc_list_suspend(&mb->parent.suspend_thread,
-						   thread,
-						   mb->parent.parent.flag);
-
-		/* has waiting time, start thread timer */
-		if(timeout > 0) {
-			/* reset the timeout of thread timer and start it */
-			sk_timer_control(&(thread->thread_timer),
-							 SK_TIMER_CTRL_SET_TIME,
-							 &timeout);
-			sk_timer_start(&(thread->thread_timer));
-		}
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
-	}
-
-	/* thread timer timeout and thread rerun, check mailbox is empty */
-	if(mb->entry == 0) 
-		return SK_ETIMEOUT;
-
-	/* get mails */
-	*value = mb->msg_pool[mb->out_offset];
-	/* increase output offset */
-	++mb->out_offset;
-	if(mb->out_offset >= mb->size)
-		mb->out_offset = 0;
-
-	if(mb->entry > 0)
-		mb->entry--;
-
-	/* resume suspended thread */
-	if(!sk_list_empty(&mb->parent.suspend_thread)){
-		/* get suspended thread */
-		thread = sk_list_entry(mb->parent.suspend_thread.next, 
-							   struct sk_thread,
-							   tlist); 
-		/* resume thread */
-		sk_thread_resume(thread);
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
-
-		return SK_EOK;
-	}
-	/* enable interrupt */
-	hw_interrupt_enable(temp);
+	received = __mailbox_get(mb, value, 1, timeout);
 
-	return SK_EOK;
+	return received < 0 ? received : SK_EOK;
 }
 
+/*
+ * sk_mailbox_send_n
+ * brief
+ * 		this function will send up to count mails in one critical section,
+ * 		the receivers are woken up once. if the mailbox is full, the thread
+ * 		will wait for a specified time
+ * param
+ * 		mb: pointer to the mailbox object to be sent
+ * 		value: the mails
+ * 		count: number of mails
+ * 		timeout: timeout period
+ * return
+ * 		number of mails sent, or a negative error code if none is sent
+ */
+sk_int32_t sk_mailbox_send_n(struct sk_mailbox *mb, const sk_ubase_t *value,
+							 sk_size_t count, sk_int32_t timeout)
+{
+	if(count == 0)
+		return SK_EINVAL;
 
+	return __mailbox_put(mb, value, count, timeout);
+}
 
+/*
+ * sk_mailbox_recv_n
+ * brief
+ * 		this function will receive the mails available, up to count, in one
+ * 		critical section, the senders are woken up once. if the mailbox is
+ * 		empty, the thread will wait for a specified time
+ * param
+ * 		mb: pointer to mailbox objcet that you want to received
+ * 		value: buffer of the mails
+ * 		count: maximum number of mails
+ * 		timeout: timeout period
+ * return
+ * 		number of mails received, or a negative error code if none is
+ * 		received
+ */
+sk_int32_t sk_mailbox_recv_n(struct sk_mailbox *mb, sk_ubase_t *value,
+							 sk_size_t count, sk_int32_t timeout)
+{
+	if(count == 0)
+		return SK_EINVAL;
 
-
+	return __mailbox_get(mb, value, count, timeout);
+}
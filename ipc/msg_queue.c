@@ -2,7 +2,7 @@
  *  msg_queue.c
  *  brief
  *  	message queue module of ipc
- *  
+ *
  *  (C) 2025.03.13 <hkdywg@163.com>
  *
  *  This program is free software; you can redistribute it and/r modify
@@ -14,15 +14,276 @@
 
 extern sk_err_t __ipc_list_resume_all(sk_list_t *list);
 extern sk_err_t __ipc_object_init(struct sk_ipc_object *ipc);
-extern sk_err_t __ipc_list_suspend(sk_list_t *list, 
-									  struct sk_thread *thread,
-									  sk_uint8_t flag);
+extern sk_err_t __ipc_list_wait(sk_list_t *list, sk_uint8_t flag,
+								sk_int32_t *timeout, sk_ubase_t *level);
+extern sk_uint32_t __ipc_list_resume_n(sk_list_t *list, sk_uint32_t n);
 
+/*
+ * message slot of the pool, the message content follows it
+ */
 struct sk_mq_message
 {
 	struct sk_mq_message *next;
+	sk_size_t 			 length;		/* length of the message content */
 };
 
+/* band of the plain send calls, the last band in use */
+#define SK_MQ_BAND_DEFAULT 			0xFF
+
+/* size of a message slot, the message content is kept aligned */
+#define SK_MQ_SLOT_SIZE(msg_size) 	(sizeof(struct sk_mq_message) + \
+									 SK_ALIGN((msg_size), sizeof(sk_ubase_t)))
+
+/*
+ * __msg_queue_pool_init
+ * brief
+ * 		cut the message pool into slots and put them to the free list
+ * param
+ * 		mq: pointer to message queue
+ */
+static void __msg_queue_pool_init(struct sk_msg_queue *mq)
+{
+	struct sk_mq_message *head;
+
+	/* initialize message list, strict fifo in band 0 */
+	for(sk_ubase_t i = 0; i < SK_MQ_PRIO_BANDS; i++) {
+		mq->msg_queue_head[i] = SK_NULL;
+		mq->msg_queue_tail[i] = SK_NULL;
+	}
+	mq->msg_queue_free = SK_NULL;
+	mq->band_map = 0;
+	mq->bands = 1;
+
+	for(sk_ubase_t i = 0; i < mq->max_msgs; i++){
+		head = (struct sk_mq_message *)((sk_uint8_t *)mq->msg_pool +
+										i * SK_MQ_SLOT_SIZE(mq->msg_size));
+		head->next = (struct sk_mq_message *)mq->msg_queue_free;
+		mq->msg_queue_free = head;
+	}
+
+	/* the initial entry is zero */
+	mq->entry = 0;
+
+	/* initialize an additional list of sender suspend thread */
+	sk_list_init(&(mq->suspend_sender_thread));
+}
+
+/*
+ * __msg_queue_alloc
+ * brief
+ * 		take up to count free message slots in one critical section, wait
+ * 		for the first one up to specified time
+ * param
+ * 		mq: pointer to message queue
+ * 		msg: the slots taken, linked by next
+ * 		count: maximum number of slots
+ * 		timeout: timeout period
+ * return
+ * 		number of slots taken, or a negative error code
+ */
+static sk_int32_t __msg_queue_alloc(struct sk_msg_queue *mq, struct sk_mq_message **msg,
+									sk_size_t count, sk_int32_t timeout)
+{
+	struct sk_mq_message *last;
+	sk_int32_t taken;
+	sk_ubase_t temp;
+	sk_err_t err;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* message queue is full */
+	while(mq->msg_queue_free == SK_NULL) {
+		/* for non-blocking call */
+		if(timeout == 0) {
+			hw_interrupt_enable(temp);
+			return SK_EFULL;
+		}
+
+		err = __ipc_list_wait(&(mq->suspend_sender_thread), mq->parent.parent.flag,
+							  &timeout, &temp);
+		if(err != SK_EOK) {
+			hw_interrupt_enable(temp);
+			return err;
+		}
+	}
+
+	/* cut the slots from the free list */
+	*msg = last = (struct sk_mq_message *)mq->msg_queue_free;
+	for(taken = 1; taken < count && last->next != SK_NULL; taken++)
+		last = last->next;
+	mq->msg_queue_free = last->next;
+	last->next = SK_NULL;
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	return taken;
+}
+
+/*
+ * __msg_queue_put
+ * brief
+ * 		link filled slots to the tail of a band, or to its head for urgent
+ * 		messages, and wake up the receivers, once for all of them
+ * param
+ * 		mq: pointer to message queue
+ * 		msg: the filled slots, linked by next
+ * 		count: number of slots
+ * 		band: the priority band, SK_MQ_BAND_DEFAULT for the lowest one
+ * 		urgent: link the slots to the band head
+ */
+static void __msg_queue_put(struct sk_msg_queue *mq, struct sk_mq_message *msg,
+							sk_size_t count, sk_uint8_t band, sk_bool_t urgent)
+{
+	struct sk_mq_message *last;
+	sk_ubase_t temp;
+	sk_uint32_t woken;
+
+	for(last = msg; last->next != SK_NULL; last = last->next);
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	if(band == SK_MQ_BAND_DEFAULT)
+		band = mq->bands - 1;
+
+	if(urgent) {
+		/* link msg to band head */
+		last->next = (struct sk_mq_message *)mq->msg_queue_head[band];
+		mq->msg_queue_head[band] = msg;
+		if(mq->msg_queue_tail[band] == SK_NULL)
+			mq->msg_queue_tail[band] = last;
+	} else {
+		/* link msg to band tail */
+		if(mq->msg_queue_tail[band] != SK_NULL)
+			((struct  sk_mq_message *)mq->msg_queue_tail[band])->next = msg;
+		mq->msg_queue_tail[band] = last;
+		/* if the head is empty, set head */
+		if(mq->msg_queue_head[band] == SK_NULL)
+			mq->msg_queue_head[band] = msg;
+	}
+	mq->band_map |= 1U << band;
+
+	/* increase message entry */
+	mq->entry += count;
+
+	/* resume suspended receivers */
+	woken = __ipc_list_resume_n(&(mq->parent.suspend_thread), count);
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	if(woken)
+		sk_schedule();
+}
+
+/*
+ * __msg_queue_get
+ * brief
+ * 		unlink up to count messages at the queue head in one critical
+ * 		section, wait for the first one up to specified time. the first
+ * 		band holding messages is found by the band bitmap
+ * param
+ * 		mq: pointer to message queue
+ * 		msg: the slots of the messages, linked by next
+ * 		count: maximum number of messages
+ * 		timeout: timeout period
+ * return
+ * 		number of messages taken, or a negative error code
+ */
+static sk_int32_t __msg_queue_get(struct sk_msg_queue *mq, struct sk_mq_message **msg,
+								  sk_size_t count, sk_int32_t timeout)
+{
+	struct sk_mq_message *last, **link;
+	sk_int32_t taken = 0;
+	sk_uint32_t band;
+	sk_ubase_t temp;
+	sk_err_t err;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* message queue is empty */
+	while(mq->entry == 0) {
+		/* for non-blocking call */
+		if(timeout == 0) {
+			hw_interrupt_enable(temp);
+			return SK_ETIMEOUT;
+		}
+
+		err = __ipc_list_wait(&(mq->parent.suspend_thread), mq->parent.parent.flag,
+							  &timeout, &temp);
+		if(err != SK_EOK) {
+			hw_interrupt_enable(temp);
+			return err;
+		}
+	}
+
+	/* cut the messages from the head of the highest bands */
+	link = msg;
+	while(taken < count && mq->band_map != 0) {
+		band = __sk_ffs(mq->band_map) - 1;
+
+		*link = last = (struct sk_mq_message *)mq->msg_queue_head[band];
+		for(taken++; taken < count && last->next != SK_NULL; taken++)
+			last = last->next;
+
+		/* move band head */
+		mq->msg_queue_head[band] = last->next;
+		/*  reach band tail, set to NULL */
+		if(mq->msg_queue_tail[band] == last) {
+			mq->msg_queue_tail[band] = SK_NULL;
+			mq->band_map &= ~(1U << band);
+		}
+		last->next = SK_NULL;
+		link = &(last->next);
+	}
+
+	mq->entry -= taken;
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	return taken;
+}
+
+/*
+ * __msg_queue_free
+ * brief
+ * 		put slots back to the free list and wake up the senders, once for
+ * 		all of them
+ * param
+ * 		mq: pointer to message queue
+ * 		msg: the slots to be freed, linked by next
+ * 		count: number of slots
+ */
+static void __msg_queue_free(struct sk_msg_queue *mq, struct sk_mq_message *msg,
+							 sk_size_t count)
+{
+	struct sk_mq_message *last;
+	sk_ubase_t temp;
+	sk_uint32_t woken;
+
+	for(last = msg; last->next != SK_NULL; last = last->next);
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* put message to free list */
+	last->next = (struct sk_mq_message *)mq->msg_queue_free;
+	mq->msg_queue_free = msg;
+
+	/* resume suspended senders */
+	woken = __ipc_list_resume_n(&(mq->suspend_sender_thread), count);
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	if(woken)
+		sk_schedule();
+}
+
 /*
  * sk_msg_queue_create
  * brief
@@ -31,13 +292,12 @@ struct sk_mq_message
  * 		name: the name of message queue
  * 		msg_size: number of each message list
  * 		max_msgs: maximum number of messages inn the message queue
- * 		flag: the flag of mailbox, can be set SK_IPC_FLAG_PRIO or SK_IPC_FLAG_FIFO 
+ * 		flag: the flag of mailbox, can be set SK_IPC_FLAG_PRIO or SK_IPC_FLAG_FIFO
  */
 struct sk_msg_queue *sk_msg_queue_create(const char *name, sk_size_t msg_size,
 									   sk_size_t max_msgs, sk_uint8_t flag)
 {
 	struct sk_msg_queue *mq;
-	struct sk_mq_message *head;
 
 	/* allocate object */
 	mq = (struct sk_msg_queue *)sk_object_alloc(SK_OBJECT_MSQUE, name);
@@ -52,30 +312,15 @@ struct sk_msg_queue *sk_msg_queue_create(const char *name, sk_size_t msg_size,
 
 	mq->msg_size = msg_size;
 	mq->max_msgs = max_msgs;
-	mq->msg_pool = sk_malloc((mq->msg_size + sizeof(struct sk_mq_message)) * mq->max_msgs);
-	if(mq->msg_pool) {
+	mq->msg_pool = sk_malloc(SK_MQ_SLOT_SIZE(mq->msg_size) * mq->max_msgs);
+	if(mq->msg_pool == SK_NULL) {
 		/* delete message queue object */
 		sk_object_delete(&(mq->parent.parent));
 
 		return SK_NULL;
 	}
-	/* initialize message list */
-	mq->msg_queue_head = SK_NULL;
-	mq->msg_queue_tail = SK_NULL;
-	mq->msg_queue_free = SK_NULL;
 
-	for(sk_ubase_t i = 0; i < mq->max_msgs; i++){
-		head = (struct sk_mq_message *)((sk_uint8_t *)mq->msg_pool + 
-										i * (mq->msg_size + sizeof(struct sk_mq_message)));
-		head->next = (struct sk_mq_message *)mq->msg_queue_free;
-		mq->msg_queue_free = head;
-	}
-
-	/* the initial entry is zero */
-	mq->entry = 0;
-
-	/* initialize an additional list of sender suspend thread */
-	sk_list_init(&(mq->suspend_sender_thread));
+	__msg_queue_pool_init(mq);
 
 	return mq;
 }
@@ -86,16 +331,17 @@ struct sk_msg_queue *sk_msg_queue_create(const char *name, sk_size_t msg_size,
  * brief
  * 		this function will create a message queue object(static)
  * param
- * 		mq: pointer to message queue 
+ * 		mq: pointer to message queue
  * 		name: the name of message queue
  * 		msg_size: number of each message list
  * 		max_msgs: maximum number of messages inn the message queue
- * 		flag: the flag of mailbox, can be set SK_IPC_FLAG_PRIO or SK_IPC_FLAG_FIFO 
+ * 		flag: the flag of mailbox, can be set SK_IPC_FLAG_PRIO or SK_IPC_FLAG_FIFO
  */
-struct sk_msg_queue *sk_msg_queue_init(struct sk_msg_queue *mq, const char *name, void *msgpool, 
+struct sk_msg_queue *sk_msg_queue_init(struct sk_msg_queue *mq, const char *name, void *msgpool,
 									   sk_size_t msg_size, sk_size_t pool_size, sk_uint8_t flag)
 {
-	struct sk_mq_message *head;
+	/* initialize object */
+	sk_object_init(&(mq->parent.parent), SK_OBJECT_MSQUE, name);
 
 	/* set mailbox flag */
 	mq->parent.parent.flag = flag;
@@ -107,26 +353,11 @@ struct sk_msg_queue *sk_msg_queue_init(struct sk_msg_queue *mq, const char *name
 	mq->msg_pool = msgpool;
 
 	mq->msg_size = msg_size;
-	mq->max_msgs = pool_size / (mq->msg_size + sizeof(struct sk_mq_message));
-	/* initialize message list */
-	mq->msg_queue_head = SK_NULL;
-	mq->msg_queue_tail = SK_NULL;
-	mq->msg_queue_free = SK_NULL;
+	mq->max_msgs = pool_size / SK_MQ_SLOT_SIZE(mq->msg_size);
 
-	for(sk_ubase_t i = 0; i < mq->max_msgs; i++){
-		head = (struct sk_mq_message *)((sk_uint8_t *)mq->msg_pool + 
-										i * (mq->msg_size + sizeof(struct sk_mq_message)));
-		head->next = (struct sk_mq_message *)mq->msg_queue_free;
-		mq->msg_queue_free = head;
-	}
-
-	/* the initial entry is zero */
-	mq->entry = 0;
-
-	/* initialize an additional list of sender suspend thread */
-	sk_list_init(&(mq->suspend_sender_thread));
+	__msg_queue_pool_init(mq);
 
-	return SK_EOK;
+	return mq;
 }
 
 /*
@@ -138,9 +369,29 @@ struct sk_msg_queue *sk_msg_queue_init(struct sk_msg_queue *mq, const char *name
  */
 sk_err_t sk_msg_queue_delete(struct sk_msg_queue *mq)
 {
+	sk_list_t *n;
+	struct sk_thread *thread;
+	sk_ubase_t temp;
+
 	if(mq == SK_NULL)
 		return SK_EOK;
 
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* waiting threads return with error */
+	sk_list_for_each(n, &(mq->parent.suspend_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+	sk_list_for_each(n, &(mq->suspend_sender_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
 	/* wakeup all syspended threads */
 	__ipc_list_resume_all(&(mq->parent.suspend_thread));
 
@@ -159,113 +410,59 @@ sk_err_t sk_msg_queue_delete(struct sk_msg_queue *mq)
 
 
 /*
- * sk_msg_queue_send_wait
+ * __msg_queue_send
  * brief
- * 		this function will send a message to the message queue object. if there is a thread suspended on
- * 		the message queue, the thread will be resumed
+ * 		copy a message to a free slot and link it to a band
  * param
- * 		mq: pointer to the message queue object to be sent 
+ * 		mq: pointer to message queue
  * 		buffer: the content of the message
  * 		size: the length of message
+ * 		band: the priority band, SK_MQ_BAND_DEFAULT for the lowest one
+ * 		urgent: link the message to the band head
  * 		timeout: timeout period
  */
-sk_err_t sk_msg_queue_send_wait(struct sk_msg_queue *mq,
-						 const void *buffer,
-						 sk_size_t size,
-						 sk_int32_t timeout)
+static sk_err_t __msg_queue_send(struct sk_msg_queue *mq, const void *buffer, sk_size_t size,
+								 sk_uint8_t band, sk_bool_t urgent, sk_int32_t timeout)
 {
-	struct sk_thread *thread;
 	struct sk_mq_message *msg;
-	sk_ubase_t temp;
+	sk_err_t err;
 
 	/* greater than one message size */
 	if(size > mq->msg_size)
 		return SK_ERROR;
 
-	/* get current thread */
-	thread = sk_current_thread();
+	err = __msg_queue_alloc(mq, &msg, 1, timeout);
+	if(err < 0)
+		return err;
 
-	/* disable interrupt */
-	temp = hw_interrupt_disable();
-
-	/* get a free list, there must be a empty item */
-	msg = (struct sk_mq_message *)mq->msg_queue_free;
-
-	/* for non-blocking call */
-	if(msg == SK_NULL && timeout == 0) {
-		hw_interrupt_enable(temp);
-		return SK_EFULL;
-	}
-
-	/* message queue is full */
-	if(mq == SK_NULL) {
-		/* suspend current thread */
-		__ipc_list_suspend(&(mq->suspend_sender_thread),
-						   thread,
-						   mq->parent.parent.flag);
-		/* has waiting time, start thread timer */
-		if(timeout > 0) {
-			/* reset the timeout of thread timer and start it */
-			sk_timer_control(&(thread->thread_timer),
-							 SK_TIMER_CTRL_SET_TIME,
-							 &timeout);
-			sk_timer_start(&(thread->thread_timer));
-		}
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
-	}
-
-	/* move free list pointer */
-	mq->msg_queue_free = msg->next;
-
-	/* enable interrupt */
-	hw_interrupt_enable(temp);
-
-	/* the msg is the new tailer of list, the next shall be NULL */
-	msg->next = SK_NULL;
 	/* copy buffer */
 	sk_memcpy(msg + 1, buffer, size);
+	msg->length = size;
 
-	/* disable interrupt */
-	temp = hw_interrupt_disable();
-
-	/* link msg to message queue */
-	if(mq->msg_queue_tail != SK_NULL)
-		((struct  sk_mq_message *)mq->msg_queue_tail)->next = msg;
-	mq->msg_queue_tail = msg;
-	/* if the head is empty, set head */
-	if(mq->msg_queue_head == SK_NULL)
-		mq->msg_queue_head = msg;
-	/* increase message entry */
-	mq->entry++;
-
-	/* resume suspended thread */
-	if(!sk_list_empty(&mq->parent.suspend_thread)){
-		/* get suspended thread */
-		thread = sk_list_entry(mq->parent.suspend_thread.next, 
-							   struct sk_thread,
-							   tlist); 
-		/* resume thread */
-		sk_thread_resume(thread);
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
-
-		return SK_EOK;
-	}
-	/* enable interrupt */
-	hw_interrupt_enable(temp);
+	__msg_queue_put(mq, msg, 1, band, urgent);
 
 	return SK_EOK;
 }
 
+/*
+ * sk_msg_queue_send_wait
+ * brief
+ * 		this function will send a message to the message queue object. if there is a thread suspended on
+ * 		the message queue, the thread will be resumed
+ * param
+ * 		mq: pointer to the message queue object to be sent
+ * 		buffer: the content of the message
+ * 		size: the length of message
+ * 		timeout: timeout period
+ */
+sk_err_t sk_msg_queue_send_wait(struct sk_msg_queue *mq,
+						 const void *buffer,
+						 sk_size_t size,
+						 sk_int32_t timeout)
+{
+	return __msg_queue_send(mq, buffer, size, SK_MQ_BAND_DEFAULT, SK_FALSE, timeout);
+}
+
 /*
  * sk_msg_queue_send
  * brief
@@ -276,6 +473,42 @@ sk_err_t sk_msg_queue_send(struct sk_msg_queue *mq, const void *buffer, sk_size_
 	return sk_msg_queue_send_wait(mq, buffer, size, 0);
 }
 
+/*
+ * sk_msg_queue_send_prio
+ * brief
+ * 		this function will send a message to a priority band, the messages
+ * 		of band 0 are received first. the plain send calls use the last band
+ * param
+ * 		mq: pointer to the message queue object to be sent
+ * 		buffer: the content of the message
+ * 		size: the length of message
+ * 		prio: the priority band, less than the bands set by sk_msg_queue_control()
+ * 		timeout: timeout period
+ */
+sk_err_t sk_msg_queue_send_prio(struct sk_msg_queue *mq, const void *buffer,
+								sk_size_t size, sk_uint8_t prio, sk_int32_t timeout)
+{
+	if(prio >= mq->bands)
+		return SK_EINVAL;
+
+	return __msg_queue_send(mq, buffer, size, prio, SK_FALSE, timeout);
+}
+
+/*
+ * sk_msg_queue_urgent
+ * brief
+ * 		this function will send a message no wait to the head of the queue,
+ * 		it is received before all the messages queued
+ * param
+ * 		mq: pointer to the message queue object to be sent
+ * 		buffer: the content of the message
+ * 		size: the length of message
+ */
+sk_err_t sk_msg_queue_urgent(struct sk_msg_queue *mq, const void *buffer, sk_size_t size)
+{
+	return __msg_queue_send(mq, buffer, size, 0, SK_TRUE, 0);
+}
+
 /*
  * sk_msg_queue_recv
  * breif
@@ -286,97 +519,248 @@ sk_err_t sk_msg_queue_send(struct sk_msg_queue *mq, const void *buffer, sk_size_
  * 		value: pointer for receive mailbox
  * 		timeout: timeout period
  */
-sk_err_t sk_msg_queue_recv(struct sk_msg_queue *mq, void *buffer, 
+sk_err_t sk_msg_queue_recv(struct sk_msg_queue *mq, void *buffer,
 						   sk_size_t size, sk_int32_t timeout)
 {
-	struct sk_thread *thread;
 	struct sk_mq_message *msg;
-	sk_ubase_t temp;
+	sk_err_t err;
 
-	/* get current thread */
-	thread = sk_current_thread();
+	err = __msg_queue_get(mq, &msg, 1, timeout);
+	if(err < 0)
+		return err;
 
-	/* disable interrupt */
-	temp = hw_interrupt_disable();
+	/* copy message */
+	sk_memcpy(buffer, msg + 1, size > msg->length ? msg->length : size);
 
-	/* for non-blocking call */
-	if(mq->entry == 0 && timeout == 0) {
-		hw_interrupt_enable(temp);
-		return SK_ETIMEOUT;
-	}
+	__msg_queue_free(mq, msg, 1);
 
-	/* message queue is empty */
-	if(mq->entry == 0){
-		/* suspend current thread */
-		__ipc_list_suspend(&mq->parent.suspend_thread,
-						   thread,
-						   mq->parent.parent.flag);
-
-		/* has waiting time, start thread timer */
-		if(timeout > 0) {
-			/* reset the timeout of thread timer and start it */
-			sk_timer_control(&(thread->thread_timer),
-							 SK_TIMER_CTRL_SET_TIME,
-							 &timeout);
-			sk_timer_start(&(thread->thread_timer));
-		}
+	return SK_EOK;
+}
 
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
+/*
+ * sk_msg_queue_send_n
+ * brief
+ * 		this function will send up to count messages of the same size. the
+ * 		free slots are taken and the messages are linked to the queue in one
+ * 		critical section each, the receivers are woken up once. if the
+ * 		message queue is full, the thread will wait for a specified time
+ * param
+ * 		mq: pointer to message queue
+ * 		buffer: the contents of the messages, one after another
+ * 		size: the length of each message
+ * 		count: number of messages
+ * 		timeout: timeout period
+ * return
+ * 		number of messages sent, or a negative error code if none is sent
+ */
+sk_int32_t sk_msg_queue_send_n(struct sk_msg_queue *mq, const void *buffer,
+							   sk_size_t size, sk_size_t count, sk_int32_t timeout)
+{
+	struct sk_mq_message *msg, *iter;
+	const sk_uint8_t *content = (const sk_uint8_t *)buffer;
+	sk_int32_t taken;
+
+	/* greater than one message size */
+	if(size > mq->msg_size || count == 0)
+		return SK_EINVAL;
+
+	taken = __msg_queue_alloc(mq, &msg, count, timeout);
+	if(taken < 0)
+		return taken;
+
+	/* copy buffer */
+	for(iter = msg; iter != SK_NULL; iter = iter->next) {
+		sk_memcpy(iter + 1, content, size);
+		iter->length = size;
+		content += size;
 	}
 
-	/* thread timer timeout and thread rerun, check mailbox is empty */
-	if(mq->entry == 0) 
-		return SK_ETIMEOUT;
+	__msg_queue_put(mq, msg, taken, SK_MQ_BAND_DEFAULT, SK_FALSE);
 
-	/* get message from queue */
-	msg = (struct sk_mq_message *)mq->msg_queue_head;
+	return taken;
+}
 
-	/* move message queue head */
-	mq->msg_queue_head = msg->next;
-	/*  reach queue tail, set to NULL */
-	if(mq->msg_queue_tail == msg)
-		mq->msg_queue_tail = SK_NULL;
+/*
+ * sk_msg_queue_recv_n
+ * brief
+ * 		this function will receive the messages available, up to count. the
+ * 		messages are taken and the slots are freed in one critical section
+ * 		each, the senders are woken up once. if the message queue is empty,
+ * 		the thread will wait for a specified time
+ * param
+ * 		mq: pointer to message queue
+ * 		buffer: buffer of the messages, one after another
+ * 		size: the size of buffer for each message
+ * 		count: maximum number of messages
+ * 		timeout: timeout period
+ * return
+ * 		number of messages received, or a negative error code if none is
+ * 		received
+ */
+sk_int32_t sk_msg_queue_recv_n(struct sk_msg_queue *mq, void *buffer,
+							   sk_size_t size, sk_size_t count, sk_int32_t timeout)
+{
+	struct sk_mq_message *msg, *iter;
+	sk_uint8_t *content = (sk_uint8_t *)buffer;
+	sk_int32_t taken;
 
-	if(mq->entry > 0)
-		mq->entry--;
+	if(count == 0)
+		return SK_EINVAL;
 
-	/* enable interrupt */
-	hw_interrupt_enable(temp);
+	taken = __msg_queue_get(mq, &msg, count, timeout);
+	if(taken < 0)
+		return taken;
 
 	/* copy message */
-	sk_memcpy(buffer, msg + 1, size > mq->msg_size ? mq->msg_size : size);
+	for(iter = msg; iter != SK_NULL; iter = iter->next) {
+		sk_memcpy(content, iter + 1, size > iter->length ? iter->length : size);
+		content += size;
+	}
 
-	/* disable interrupt */
-	temp = hw_interrupt_disable();
-	/* put message to free list */
-	msg->next = (struct sk_mq_message *)mq->msg_queue_free;
-	mq->msg_queue_free = msg;
+	__msg_queue_free(mq, msg, taken);
 
-	/* resume suspended thread */
-	if(!sk_list_empty(&mq->parent.suspend_thread)){
-		/* get suspended thread */
-		thread = sk_list_entry(mq->parent.suspend_thread.next, 
-							   struct sk_thread,
-							   tlist); 
-		/* resume thread */
-		sk_thread_resume(thread);
-
-		/* enable interrupt */
-		hw_interrupt_enable(temp);
-	
-		/* do schedule */
-		sk_schedule();
+	return taken;
+}
 
-		return SK_EOK;
-	}
-	/* enable interrupt */
-	hw_interrupt_enable(temp);
+/*
+ * sk_msg_queue_reserve
+ * brief
+ * 		this function will take a free message slot for the sender to write
+ * 		the message in place, the message is sent by sk_msg_queue_commit().
+ * 		if the message queue is full, the thread will wait for a specified time
+ * param
+ * 		mq: pointer to message queue
+ * 		buffer: content buffer of the slot, msg_size bytes
+ * 		timeout: timeout period
+ */
+sk_err_t sk_msg_queue_reserve(struct sk_msg_queue *mq, void **buffer, sk_int32_t timeout)
+{
+	struct sk_mq_message *msg;
+	sk_err_t err;
+
+	err = __msg_queue_alloc(mq, &msg, 1, timeout);
+	if(err < 0)
+		return err;
+
+	*buffer = msg + 1;
 
 	return SK_EOK;
 }
 
+/*
+ * sk_msg_queue_commit
+ * brief
+ * 		this function will send the message written in a slot taken by
+ * 		sk_msg_queue_reserve(), without copy
+ * param
+ * 		mq: pointer to message queue
+ * 		buffer: content buffer returned by sk_msg_queue_reserve()
+ * 		size: the length of message
+ */
+sk_err_t sk_msg_queue_commit(struct sk_msg_queue *mq, void *buffer, sk_size_t size)
+{
+	struct sk_mq_message *msg = (struct sk_mq_message *)buffer - 1;
+
+	/* greater than one message size */
+	if(size > mq->msg_size)
+		return SK_ERROR;
 
+	msg->next = SK_NULL;
+	msg->length = size;
+	__msg_queue_put(mq, msg, 1, SK_MQ_BAND_DEFAULT, SK_FALSE);
+
+	return SK_EOK;
+}
+
+/*
+ * sk_msg_queue_peek
+ * brief
+ * 		this function will take the message at the queue head and return
+ * 		its slot for the receiver to read in place, the slot is given back
+ * 		by sk_msg_queue_release(). if the message queue is empty, the thread
+ * 		will wait for a specified time
+ * param
+ * 		mq: pointer to message queue
+ * 		buffer: content buffer of the message
+ * 		size: the length of message
+ * 		timeout: timeout period
+ */
+sk_err_t sk_msg_queue_peek(struct sk_msg_queue *mq, void **buffer,
+						   sk_size_t *size, sk_int32_t timeout)
+{
+	struct sk_mq_message *msg;
+	sk_err_t err;
+
+	err = __msg_queue_get(mq, &msg, 1, timeout);
+	if(err < 0)
+		return err;
+
+	*buffer = msg + 1;
+	if(size != SK_NULL)
+		*size = msg->length;
+
+	return SK_EOK;
+}
+
+/*
+ * sk_msg_queue_release
+ * brief
+ * 		this function will give back the slot of a message taken by
+ * 		sk_msg_queue_peek()
+ * param
+ * 		mq: pointer to message queue
+ * 		buffer: content buffer returned by sk_msg_queue_peek()
+ */
+sk_err_t sk_msg_queue_release(struct sk_msg_queue *mq, void *buffer)
+{
+	struct sk_mq_message *msg = (struct sk_mq_message *)buffer - 1;
+
+	msg->next = SK_NULL;
+	__msg_queue_free(mq, msg, 1);
+
+	return SK_EOK;
+}
+
+/*
+ * sk_msg_queue_control
+ * brief
+ * 		this function will get or change the priority bands of a message
+ * 		queue. the bands can be changed only when the queue is empty, one
+ * 		band makes the queue strict fifo
+ * param
+ * 		mq: pointer to message queue
+ * 		cmd: SK_MQ_CTRL_SET_BANDS or SK_MQ_CTRL_GET_BANDS
+ * 		arg: pointer to sk_uint8_t number of bands, 1 to SK_MQ_PRIO_BANDS
+ */
+sk_err_t sk_msg_queue_control(struct sk_msg_queue *mq, int cmd, void *arg)
+{
+	sk_uint8_t bands;
+	sk_ubase_t temp;
+
+	switch(cmd) {
+		case SK_MQ_CTRL_SET_BANDS:
+			bands = *(sk_uint8_t *)arg;
+			if(bands == 0 || bands > SK_MQ_PRIO_BANDS)
+				return SK_EINVAL;
+
+			/* disable interrupt */
+			temp = hw_interrupt_disable();
+
+			if(mq->entry != 0) {
+				hw_interrupt_enable(temp);
+				return SK_EBUSY;
+			}
+			mq->bands = bands;
+
+			/* enable interrupt */
+			hw_interrupt_enable(temp);
+		break;
+		case SK_MQ_CTRL_GET_BANDS:
+			*(sk_uint8_t *)arg = mq->bands;
+		break;
+		default:
+			return SK_EINVAL;
+	}
+
+	return SK_EOK;
+}
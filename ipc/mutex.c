@@ -10,12 +10,201 @@
  *  published by the Free Software Foundation.
  * */
 #include <ipc.h>
+#include <atomic.h>
 
 extern sk_err_t __ipc_list_resume_all(sk_list_t *list);
 extern sk_err_t __ipc_object_init(struct sk_ipc_object *ipc);
 extern sk_err_t __ipc_list_suspend(sk_list_t *list, 
 									  struct sk_thread *thread,
 									  sk_uint8_t flag);
+extern sk_err_t __ipc_list_insert(sk_list_t *list, 
+									  struct sk_thread *thread,
+									  sk_uint8_t flag);
+
+/*
+ * __mutex_owner
+ * brief
+ * 		return the owner thread of the mutex
+ * param
+ * 		mutex: pointer to mutex
+ */
+static inline struct sk_thread *__mutex_owner(struct sk_mutex *mutex)
+{
+	return (struct sk_thread *)(sk_atomic_load64_acquire(&mutex->owner) & ~SK_MUTEX_CONTENDED);
+}
+
+/*
+ * __mutex_acquire
+ * brief
+ * 		take a free mutex by one exclusive load/store sequence, no interrupt
+ * 		masking is needed. the mutex joins the taken list of the owner only
+ * 		when the first thread waits for it, see sk_mutex_lock(). mutexes are
+ * 		used after sk_hw_board_init() has mapped ram normal cacheable, the
+ * 		exclusives are not reliable on the device memory of mmu off
+ * param
+ * 		mutex: pointer to mutex
+ * 		thread: the new owner
+ */
+static inline sk_bool_t __mutex_acquire(struct sk_mutex *mutex, struct sk_thread *thread)
+{
+	if(sk_atomic_cmpxchg64_acquire(&mutex->owner, 0, (sk_uint64_t)thread) != 0)
+		return SK_FALSE;
+
+	mutex->value = 0;
+	mutex->hold = 1;
+
+	return SK_TRUE;
+}
+
+/*
+ * __mutex_set_contended
+ * brief
+ * 		mark the mutex contended so that the owner releases it by the slow
+ * 		path and wakes the waiters up. called with interrupt disabled
+ * param
+ * 		mutex: pointer to mutex
+ * return
+ * 		SK_FALSE if the mutex has been released in the meanwhile
+ */
+static sk_bool_t __mutex_set_contended(struct sk_mutex *mutex)
+{
+	sk_uint64_t owner, old;
+
+	owner = sk_atomic_load64_acquire(&mutex->owner);
+	while(owner != 0 && !(owner & SK_MUTEX_CONTENDED)) {
+		old = sk_atomic_cmpxchg64_acquire(&mutex->owner, owner, owner | SK_MUTEX_CONTENDED);
+		if(old == owner)
+			break;
+		owner = old;
+	}
+
+	return owner != 0;
+}
+
+/*
+ * __mutex_waiter_prio
+ * brief
+ * 		return the highest priority of threads waiting for the mutex, the
+ * 		suspend list is sorted by priority so it is the first one
+ * param
+ * 		mutex: pointer to mutex
+ */
+static sk_uint8_t __mutex_waiter_prio(struct sk_mutex *mutex)
+{
+	struct sk_thread *thread;
+
+	if(sk_list_empty(&(mutex->parent.suspend_thread)))
+		return 0xFF;
+
+	thread = sk_list_entry(mutex->parent.suspend_thread.next,
+						   struct sk_thread, tlist);
+
+	return thread->current_pri;
+}
+
+/*
+ * __mutex_inherit_prio
+ * brief
+ * 		return the priority a thread should run at: its base priority, or
+ * 		the highest priority waiting for any mutex it holds
+ * param
+ * 		thread: the owner thread
+ */
+static sk_uint8_t __mutex_inherit_prio(struct sk_thread *thread)
+{
+	sk_list_t *n;
+	struct sk_mutex *mutex;
+	sk_uint8_t priority = thread->base_pri;
+
+	sk_list_for_each(n, &(thread->taken_mutex_list)) {
+		mutex = sk_list_entry(n, struct sk_mutex, taken_list);
+		if(mutex->priority < priority)
+			priority = mutex->priority;
+	}
+
+	return priority;
+}
+
+/*
+ * __mutex_update_prio
+ * brief
+ * 		recalculate the priority of a mutex owner. if the owner is blocked
+ * 		on another mutex, the change is passed on along the chain of owners.
+ * 		called with interrupt disabled
+ * param
+ * 		thread: the owner thread whose held mutexes or base priority have changed
+ */
+void __mutex_update_prio(struct sk_thread *thread)
+{
+	struct sk_mutex *mutex;
+	sk_uint8_t priority;
+
+	while(thread != SK_NULL) {
+		priority = __mutex_inherit_prio(thread);
+		if(priority == thread->current_pri)
+			break;
+
+		sk_thread_control(thread, SK_THREAD_CTRL_INHERIT_PRIORITY, &priority);
+
+		mutex = thread->pending_mutex;
+		if(mutex == SK_NULL)
+			break;
+
+		/* keep the suspend list sorted by the new priority */
+		sk_list_del(&(thread->tlist));
+		__ipc_list_insert(&(mutex->parent.suspend_thread), thread, SK_IPC_FLAG_PRIO);
+		mutex->priority = __mutex_waiter_prio(mutex);
+
+		/* next owner of the chain */
+		thread = __mutex_owner(mutex);
+	}
+}
+
+/*
+ * __mutex_requeue
+ * brief
+ * 		move a thread suspended on another ipc object to the mutex, used by
+ * 		the condition variable. the thread takes the mutex if it is free,
+ * 		otherwise it waits for the mutex as if it had called sk_mutex_lock().
+ * 		called with interrupt disabled
+ *
+ * note: don't invoke this function in application
+ *
+ * param
+ * 		mutex: pointer to mutex
+ * 		thread: the suspended thread
+ * return
+ * 		SK_TRUE if the thread has taken the mutex and is to be resumed
+ */
+sk_bool_t __mutex_requeue(struct sk_mutex *mutex, struct sk_thread *thread)
+{
+	struct sk_thread *owner;
+
+	/* the owner may release the mutex until it is marked contended */
+	while(!__mutex_acquire(mutex, thread)) {
+		if(!__mutex_set_contended(mutex))
+			continue;
+
+		/* the first waiter puts the mutex on the taken list of the owner */
+		owner = __mutex_owner(mutex);
+		if(sk_list_empty(&(mutex->taken_list)))
+			sk_list_add(&(owner->taken_mutex_list), &(mutex->taken_list));
+
+		thread->pending_mutex = mutex;
+		sk_list_del(&(thread->tlist));
+		__ipc_list_insert(&(mutex->parent.suspend_thread), thread, SK_IPC_FLAG_PRIO);
+
+		/* owner inherits priority of the waiter, along the chain */
+		if(thread->current_pri < mutex->priority) {
+			mutex->priority = thread->current_pri;
+			__mutex_update_prio(owner);
+		}
+
+		return SK_FALSE;
+	}
+
+	return SK_TRUE;
+}
 
 /*
  * sk_mutex_init
@@ -37,9 +226,10 @@ sk_err_t sk_mutex_init(struct sk_mutex *mutex, const char *name, sk_uint8_t flag
 	__ipc_object_init(&(mutex->parent));
 
 	mutex->value 		= 1;
-	mutex->owner 		= SK_NULL;
-	mutex->original_pri = 0xFF;
+	mutex->owner 		= 0;
 	mutex->hold 		= 0;
+	mutex->priority 	= 0xFF;
+	sk_list_init(&(mutex->taken_list));
 
 	/* flag can only be SK_IPC_FLAG_PRIO */
 	mutex->parent.parent.flag = SK_IPC_FLAG_PRIO;
@@ -69,9 +259,10 @@ struct sk_mutex *sk_mutex_create(const char *name, sk_uint8_t flag)
 	__ipc_object_init(&(mutex->parent));
 
 	mutex->value 		= 1;
-	mutex->owner 		= SK_NULL;
-	mutex->original_pri = 0xFF;
+	mutex->owner 		= 0;
 	mutex->hold 		= 0;
+	mutex->priority 	= 0xFF;
+	sk_list_init(&(mutex->taken_list));
 
 	/* flag can only be SK_IPC_FLAG_PRIO */
 	mutex->parent.parent.flag = SK_IPC_FLAG_PRIO;
@@ -88,9 +279,31 @@ struct sk_mutex *sk_mutex_create(const char *name, sk_uint8_t flag)
  */
 sk_err_t sk_mutex_delete(struct sk_mutex *mutex)
 {
+	sk_list_t *n;
+	struct sk_thread *thread;
+	sk_ubase_t temp;
+
 	if(mutex == SK_NULL)
 		return SK_EOK;
 
+	/* disable interrupt */	
+	temp = hw_interrupt_disable();
+
+	/* waiting threads will not get the mutex */
+	sk_list_for_each(n, &(mutex->parent.suspend_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->pending_mutex = SK_NULL;
+		thread->error = SK_ERROR;
+	}
+
+	/* the owner no longer inherits from the waiters */
+	sk_list_del(&(mutex->taken_list));
+	mutex->priority = 0xFF;
+	__mutex_update_prio(__mutex_owner(mutex));
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
 	/* wakeup all syspended threads */
 	__ipc_list_resume_all(&(mutex->parent.suspend_thread));
 
@@ -112,16 +325,20 @@ sk_err_t sk_mutex_delete(struct sk_mutex *mutex)
  */
 sk_err_t sk_mutex_lock(struct sk_mutex *mutex, sk_int32_t time)
 {
-	struct sk_thread *thread;
+	struct sk_thread *thread, *owner;
 	sk_ubase_t temp;
 
 	/* get current thread */
 	thread = sk_current_thread();
 
+	/* fast path, the mutex is free */
+	if(__mutex_acquire(mutex, thread))
+		return SK_EOK;
+
 	/* disable interrupt */	
 	temp = hw_interrupt_disable();
 
-	if(mutex->owner == thread) {
+	if(__mutex_owner(mutex) == thread) {
 		if(mutex->hold < SK_MUTEX_HOLD_MAX){
 			mutex->hold++;
 		} else {
@@ -130,46 +347,64 @@ sk_err_t sk_mutex_lock(struct sk_mutex *mutex, sk_int32_t time)
 			return SK_EFULL;
 		}
 	} else {
-		/* the value of mutex is 1 in initial status. therefore, if the value
-		 * is great thann 0, it indicates the mutex is avaible */
-		if(mutex->value > 0) {
-			/* mutex is available */
-			mutex->value --;
-
-			/* set mutex owner and original priority */
-			mutex->owner = thread;
-			mutex->original_pri = thread->current_pri;
-			if(mutex->hold < SK_MUTEX_HOLD_MAX){
-				mutex->hold++;
-			} else {
-				/* enable interrupt */
-				hw_interrupt_enable(temp);
-				return SK_EFULL;
-			}
-		} else {
+		/* the owner may release the mutex until it is marked contended */
+		while(!__mutex_acquire(mutex, thread)) {
 			/* no waiting, return with timeout */
 			if(time == 0) {
 				/* enable interrupt */
 				hw_interrupt_enable(temp);
 				return SK_ETIMEOUT;
-			} else {
-				/* suspend current thread */
-				__ipc_list_suspend(&(mutex->parent.suspend_thread), thread, SK_IPC_FLAG_PRIO);
+			}
+
+			if(!__mutex_set_contended(mutex))
+				continue;
+
+			/* the first waiter puts the mutex on the taken list of the owner */
+			owner = __mutex_owner(mutex);
+			if(sk_list_empty(&(mutex->taken_list)))
+				sk_list_add(&(owner->taken_mutex_list), &(mutex->taken_list));
+
+			/* suspend current thread */
+			thread->error = SK_EOK;
+			thread->pending_mutex = mutex;
+			__ipc_list_suspend(&(mutex->parent.suspend_thread), thread, SK_IPC_FLAG_PRIO);
+
+			/* owner inherits priority of the waiter, along the chain */
+			if(thread->current_pri < mutex->priority) {
+				mutex->priority = thread->current_pri;
+				__mutex_update_prio(owner);
+			}
+
+			if(time > 0) {
+				/* reset the timeout thread timer and start it */
+				sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &time);
+				sk_timer_start(&(thread->thread_timer));
+			}
+
+			/* enable interrupt */
+			hw_interrupt_enable(temp);
+
+			/* do schedule */
+			sk_schedule();
 
-				if(time > 0) {
-					/* reset the timeout thread timer and start it */
-					sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &time);
-					sk_timer_start(&(thread->thread_timer));
-				}
+			if(thread->error == SK_ETIMEOUT) {
+				/* disable interrupt */	
+				temp = hw_interrupt_disable();
+
+				/* timed out, sk_thread_timeout() has taken it out of the list,
+				 * owner may be running at the priority inherited from it */
+				thread->pending_mutex = SK_NULL;
+				mutex->priority = __mutex_waiter_prio(mutex);
+				__mutex_update_prio(__mutex_owner(mutex));
 
 				/* enable interrupt */
 				hw_interrupt_enable(temp);
 
 				/* do schedule */
 				sk_schedule();
-
-				return SK_EOK;
 			}
+
+			return thread->error;
 		}
 	}
 	
@@ -210,11 +445,23 @@ sk_err_t sk_mutex_unlock(struct sk_mutex *mutex)
 	/* get current thread */
 	thread = sk_current_thread();
 
+	/* fast path, the last release of a mutex nobody waits for */
+	if(mutex->owner == (sk_uint64_t)thread && mutex->hold == 1) {
+		mutex->hold = 0;
+		mutex->value = 1;
+		if(sk_atomic_cmpxchg64_release(&mutex->owner, (sk_uint64_t)thread, 0) == (sk_uint64_t)thread)
+			return SK_EOK;
+
+		/* a thread began to wait in the meanwhile */
+		mutex->hold = 1;
+		mutex->value = 0;
+	}
+
 	/* disable interrupt */	
 	temp = hw_interrupt_disable();
 
 	/* mutex only can be released by owner */
-	if(thread != mutex->owner) {
+	if(thread != __mutex_owner(mutex)) {
 		/* enable interrupt */
 		hw_interrupt_enable(temp);
 
@@ -223,21 +470,37 @@ sk_err_t sk_mutex_unlock(struct sk_mutex *mutex)
 
 	mutex->hold--;
 	if(mutex->hold == 0) {
+		/* the mutex is no longer held by current thread */
+		sk_list_del(&(mutex->taken_list));
+
 		/* wakeup suspended thread */
 		if(!sk_list_empty(&mutex->parent.suspend_thread)) {
+			struct sk_thread *next;
 
 			/* get suspended thread */
-			thread = sk_list_entry(mutex->parent.suspend_thread.next, 
-								   struct sk_thread,
-								   tlist); 
+			next = sk_list_entry(mutex->parent.suspend_thread.next, 
+								 struct sk_thread,
+								 tlist); 
+
+			/* resume thread */
+			next->pending_mutex = SK_NULL;
+			sk_thread_resume(next);
 
-			/* set new owner and priority */
-			mutex->owner = thread;
-			mutex->original_pri = thread->current_pri;
+			/* set new owner and priority, it stays contended while others wait */
+			if(sk_list_empty(&mutex->parent.suspend_thread)) {
+				sk_atomic_store64_release(&mutex->owner, (sk_uint64_t)next);
+			} else {
+				sk_atomic_store64_release(&mutex->owner, (sk_uint64_t)next | SK_MUTEX_CONTENDED);
+				sk_list_add(&(next->taken_mutex_list), &(mutex->taken_list));
+			}
 			mutex->hold++;
 
-			/* resume thread */
-			sk_thread_resume(thread);
+			/* new owner inherits from the remaining waiters */
+			mutex->priority = __mutex_waiter_prio(mutex);
+			__mutex_update_prio(next);
+
+			/* drop the priority inherited through this mutex */
+			__mutex_update_prio(thread);
 
 			/* enable interrupt */
 			hw_interrupt_enable(temp);
@@ -248,8 +511,8 @@ sk_err_t sk_mutex_unlock(struct sk_mutex *mutex)
 			return SK_EOK;
 		} else {
 			mutex->value++;
-			mutex->owner = SK_NULL;
-			mutex->original_pri = 0xFF;
+			mutex->priority = 0xFF;
+			sk_atomic_store64_release(&mutex->owner, 0);
 		}
 	}
 
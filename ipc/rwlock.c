@@ -0,0 +1,479 @@
+/*
+ *  rwlock.c
+ *  brief
+ *  	reader-writer lock module of ipc
+ *
+ *  (C) 2025.04.28 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <ipc.h>
+#include <atomic.h>
+
+extern sk_err_t __ipc_list_resume_all(sk_list_t *list);
+extern sk_err_t __ipc_object_init(struct sk_ipc_object *ipc);
+extern sk_err_t __ipc_list_suspend(sk_list_t *list,
+									  struct sk_thread *thread,
+									  sk_uint8_t flag);
+
+/*
+ * the state word holds the number of readers and the SK_RWLOCK_WRITER bit.
+ * the lock is taken and released by one exclusive load/store sequence while
+ * nobody waits. SK_RWLOCK_WAITING is set as long as a thread waits, which
+ * makes every fast path fail, the slow paths run with interrupt disabled and
+ * hand the lock over to the waiters
+ */
+
+/*
+ * __rwlock_update_waiting
+ * brief
+ * 		clear SK_RWLOCK_WAITING when no thread waits any more. called with
+ * 		interrupt disabled
+ * param
+ * 		rwlock: pointer to rwlock
+ */
+static void __rwlock_update_waiting(struct sk_rwlock *rwlock)
+{
+	if(sk_list_empty(&(rwlock->parent.suspend_thread)) &&
+	   sk_list_empty(&(rwlock->suspend_writer_thread)))
+		sk_atomic_fetch_and32(&rwlock->state, ~SK_RWLOCK_WAITING);
+}
+
+/*
+ * __rwlock_wake_writer
+ * brief
+ * 		hand the lock over to the first waiting writer. called with interrupt
+ * 		disabled, the lock is free or held by the current thread
+ * param
+ * 		rwlock: pointer to rwlock
+ */
+static void __rwlock_wake_writer(struct sk_rwlock *rwlock)
+{
+	struct sk_thread *next;
+
+	next = sk_list_entry(rwlock->suspend_writer_thread.next, struct sk_thread, tlist);
+
+	rwlock->writer = next;
+	sk_atomic_fetch_or32(&rwlock->state, SK_RWLOCK_WRITER);
+
+	sk_thread_resume(next);
+}
+
+/*
+ * __rwlock_wake_readers
+ * brief
+ * 		hand the lock over to all waiting readers. called with interrupt
+ * 		disabled, no writer holds or waits for the lock
+ * param
+ * 		rwlock: pointer to rwlock
+ * return
+ * 		number of readers woken up
+ */
+static sk_uint32_t __rwlock_wake_readers(struct sk_rwlock *rwlock)
+{
+	struct sk_thread *next;
+	sk_uint32_t count = 0;
+
+	while(!sk_list_empty(&(rwlock->parent.suspend_thread))) {
+		next = sk_list_entry(rwlock->parent.suspend_thread.next, struct sk_thread, tlist);
+
+		/* the reader is counted before it runs again */
+		sk_atomic_fetch_add32(&rwlock->state, 1);
+		sk_thread_resume(next);
+		count++;
+	}
+
+	return count;
+}
+
+/*
+ * sk_rwlock_init
+ * brief
+ * 		this function will init a rwlock object
+ * param
+ * 		rwlock: pointer to rwlock
+ * 		name: the name of rwlock
+ * 		flag: order of waiting readers, SK_IPC_FLAG_FIFO or SK_IPC_FLAG_PRIO
+ */
+sk_err_t sk_rwlock_init(struct sk_rwlock *rwlock, const char *name, sk_uint8_t flag)
+{
+	/* initialize object */
+	sk_object_init(&(rwlock->parent.parent), SK_OBJECT_RWLOCK, name);
+
+	/* initialize ipc object */
+	__ipc_object_init(&(rwlock->parent));
+
+	rwlock->state 	= 0;
+	rwlock->writer 	= SK_NULL;
+	sk_list_init(&(rwlock->suspend_writer_thread));
+
+	rwlock->parent.parent.flag = flag;
+
+	return SK_EOK;
+}
+
+/*
+ * sk_rwlock_create
+ * brief
+ * 		this function will create a rwlock object
+ * param
+ * 		name: the name of rwlock
+ * 		flag: order of waiting readers, SK_IPC_FLAG_FIFO or SK_IPC_FLAG_PRIO
+ */
+struct sk_rwlock *sk_rwlock_create(const char *name, sk_uint8_t flag)
+{
+	struct sk_rwlock *rwlock;
+
+	/* allocate object */
+	rwlock = (struct sk_rwlock *)sk_object_alloc(SK_OBJECT_RWLOCK, name);
+	if(rwlock == SK_NULL)
+		return rwlock;
+
+	/* initialize ipc object */
+	__ipc_object_init(&(rwlock->parent));
+
+	rwlock->state 	= 0;
+	rwlock->writer 	= SK_NULL;
+	sk_list_init(&(rwlock->suspend_writer_thread));
+
+	rwlock->parent.parent.flag = flag;
+
+	return rwlock;
+}
+
+/*
+ * sk_rwlock_delete
+ * brief
+ * 		delete a rwlock object which is created by the sk_rwlock_create function
+ * param
+ * 		rwlock: pointer to rwlock object to be deleted
+ */
+sk_err_t sk_rwlock_delete(struct sk_rwlock *rwlock)
+{
+	sk_list_t *n;
+	struct sk_thread *thread;
+	sk_ubase_t temp;
+
+	if(rwlock == SK_NULL)
+		return SK_EOK;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* waiting threads will not get the lock */
+	sk_list_for_each(n, &(rwlock->parent.suspend_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+	sk_list_for_each(n, &(rwlock->suspend_writer_thread)) {
+		thread = sk_list_entry(n, struct sk_thread, tlist);
+		thread->error = SK_ERROR;
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	/* wakeup all syspended threads */
+	__ipc_list_resume_all(&(rwlock->parent.suspend_thread));
+	__ipc_list_resume_all(&(rwlock->suspend_writer_thread));
+
+	/* delete rwlock object */
+	sk_object_delete(&(rwlock->parent.parent));
+
+	return SK_EOK;
+}
+
+/*
+ * sk_rwlock_read_lock
+ * brief
+ * 		this function will take a rwlock for reading. readers share the lock,
+ * 		a reader waits while a writer holds the lock or waits for it, so a
+ * 		thread must not take the read lock recursively
+ * param
+ * 		rwlock: pointer to rwlock
+ * 		time: time out period
+ */
+sk_err_t sk_rwlock_read_lock(struct sk_rwlock *rwlock, sk_int32_t time)
+{
+	struct sk_thread *thread;
+	sk_uint32_t state, old;
+	sk_ubase_t temp;
+
+	/* fast path, no writer and nobody waits */
+	state = sk_atomic_load32_acquire(&rwlock->state);
+	while(!(state & (SK_RWLOCK_WRITER | SK_RWLOCK_WAITING))) {
+		old = sk_atomic_cmpxchg32_acquire(&rwlock->state, state, state + 1);
+		if(old == state)
+			return SK_EOK;
+		state = old;
+	}
+
+	/* get current thread */
+	thread = sk_current_thread();
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	/* a waiting writer keeps new readers out */
+	state = sk_atomic_load32_acquire(&rwlock->state);
+	if(!(state & SK_RWLOCK_WRITER) && sk_list_empty(&(rwlock->suspend_writer_thread))) {
+		sk_atomic_fetch_add32(&rwlock->state, 1);
+
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		return SK_EOK;
+	}
+
+	/* no waiting, return with timeout */
+	if(time == 0) {
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		return SK_ETIMEOUT;
+	}
+
+	/* suspend current thread, the lock is handed over when woken up */
+	sk_atomic_fetch_or32(&rwlock->state, SK_RWLOCK_WAITING);
+	thread->error = SK_EOK;
+	__ipc_list_suspend(&(rwlock->parent.suspend_thread), thread, rwlock->parent.parent.flag);
+
+	if(time > 0) {
+		/* reset the timeout thread timer and start it */
+		sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &time);
+		sk_timer_start(&(thread->thread_timer));
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	/* do schedule */
+	sk_schedule();
+
+	if(thread->error == SK_ETIMEOUT) {
+		/* disable interrupt */
+		temp = hw_interrupt_disable();
+
+		/* sk_thread_timeout() has taken it out of the list */
+		__rwlock_update_waiting(rwlock);
+
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+	}
+
+	return thread->error;
+}
+
+/*
+ * sk_rwlock_read_trylock
+ * brief
+ * 		this function will try to take a rwlock for reading. if the lock is
+ * 		unavailable, the thread return immediately.
+ * param
+ * 		rwlock: pointer to rwlock
+ */
+sk_err_t sk_rwlock_read_trylock(struct sk_rwlock *rwlock)
+{
+	return sk_rwlock_read_lock(rwlock, 0);
+}
+
+/*
+ * sk_rwlock_read_unlock
+ * brief
+ * 		this function will release a rwlock taken for reading. the last
+ * 		reader hands the lock over to the first waiting writer
+ * param
+ * 		rwlock: pointer to rwlock
+ */
+sk_err_t sk_rwlock_read_unlock(struct sk_rwlock *rwlock)
+{
+	sk_uint32_t state, old;
+	sk_ubase_t temp;
+
+	/* fast path, nobody waits */
+	state = sk_atomic_load32_acquire(&rwlock->state);
+	while(!(state & SK_RWLOCK_WAITING) && (state & SK_RWLOCK_READERS)) {
+		old = sk_atomic_cmpxchg32_release(&rwlock->state, state, state - 1);
+		if(old == state)
+			return SK_EOK;
+		state = old;
+	}
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	state = sk_atomic_load32_acquire(&rwlock->state);
+	if(!(state & SK_RWLOCK_READERS) || (state & SK_RWLOCK_WRITER)) {
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		return SK_ERROR;
+	}
+
+	state = sk_atomic_fetch_sub32(&rwlock->state, 1) - 1;
+	if((state & SK_RWLOCK_READERS) == 0 &&
+	   !sk_list_empty(&(rwlock->suspend_writer_thread))) {
+		__rwlock_wake_writer(rwlock);
+		__rwlock_update_waiting(rwlock);
+
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		/* do schedule */
+		sk_schedule();
+
+		return SK_EOK;
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	return SK_EOK;
+}
+
+/*
+ * sk_rwlock_write_lock
+ * brief
+ * 		this function will take a rwlock for writing, the thread shall wait
+ * 		until all readers and the writer have released the lock up to
+ * 		specified time
+ * param
+ * 		rwlock: pointer to rwlock
+ * 		time: time out period
+ */
+sk_err_t sk_rwlock_write_lock(struct sk_rwlock *rwlock, sk_int32_t time)
+{
+	struct sk_thread *thread;
+	sk_uint32_t state;
+	sk_ubase_t temp;
+
+	/* get current thread */
+	thread = sk_current_thread();
+
+	/* fast path, the lock is free */
+	if(sk_atomic_cmpxchg32_acquire(&rwlock->state, 0, SK_RWLOCK_WRITER) == 0) {
+		rwlock->writer = thread;
+		return SK_EOK;
+	}
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	state = sk_atomic_load32_acquire(&rwlock->state);
+	if((state & ~SK_RWLOCK_WAITING) == 0) {
+		sk_atomic_fetch_or32(&rwlock->state, SK_RWLOCK_WRITER);
+		rwlock->writer = thread;
+
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		return SK_EOK;
+	}
+
+	/* no waiting, return with timeout */
+	if(time == 0) {
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		return SK_ETIMEOUT;
+	}
+
+	/* suspend current thread, the lock is handed over when woken up */
+	sk_atomic_fetch_or32(&rwlock->state, SK_RWLOCK_WAITING);
+	thread->error = SK_EOK;
+	__ipc_list_suspend(&(rwlock->suspend_writer_thread), thread, SK_IPC_FLAG_FIFO);
+
+	if(time > 0) {
+		/* reset the timeout thread timer and start it */
+		sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &time);
+		sk_timer_start(&(thread->thread_timer));
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	/* do schedule */
+	sk_schedule();
+
+	if(thread->error == SK_ETIMEOUT) {
+		sk_bool_t woken = SK_FALSE;
+
+		/* disable interrupt */
+		temp = hw_interrupt_disable();
+
+		/* sk_thread_timeout() has taken it out of the list, the readers
+		 * kept out by it may go on */
+		state = sk_atomic_load32_acquire(&rwlock->state);
+		if(!(state & SK_RWLOCK_WRITER) && sk_list_empty(&(rwlock->suspend_writer_thread)))
+			woken = __rwlock_wake_readers(rwlock) != 0;
+		__rwlock_update_waiting(rwlock);
+
+		/* enable interrupt */
+		hw_interrupt_enable(temp);
+
+		if(woken)
+			sk_schedule();
+	}
+
+	return thread->error;
+}
+
+/*
+ * sk_rwlock_write_trylock
+ * brief
+ * 		this function will try to take a rwlock for writing. if the lock is
+ * 		unavailable, the thread return immediately.
+ * param
+ * 		rwlock: pointer to rwlock
+ */
+sk_err_t sk_rwlock_write_trylock(struct sk_rwlock *rwlock)
+{
+	return sk_rwlock_write_lock(rwlock, 0);
+}
+
+/*
+ * sk_rwlock_write_unlock
+ * brief
+ * 		this function will release a rwlock taken for writing. the lock is
+ * 		handed over to the next waiting writer, or else to all waiting readers
+ * param
+ * 		rwlock: pointer to rwlock
+ */
+sk_err_t sk_rwlock_write_unlock(struct sk_rwlock *rwlock)
+{
+	struct sk_thread *thread;
+	sk_ubase_t temp;
+
+	/* get current thread */
+	thread = sk_current_thread();
+
+	/* rwlock only can be released by writer */
+	if(rwlock->writer != thread)
+		return SK_ERROR;
+
+	/* fast path, nobody waits */
+	rwlock->writer = SK_NULL;
+	if(sk_atomic_cmpxchg32_release(&rwlock->state, SK_RWLOCK_WRITER, 0) == SK_RWLOCK_WRITER)
+		return SK_EOK;
+
+	/* disable interrupt */
+	temp = hw_interrupt_disable();
+
+	if(!sk_list_empty(&(rwlock->suspend_writer_thread))) {
+		__rwlock_wake_writer(rwlock);
+	} else {
+		sk_atomic_fetch_and32(&rwlock->state, ~SK_RWLOCK_WRITER);
+		__rwlock_wake_readers(rwlock);
+	}
+	__rwlock_update_waiting(rwlock);
+
+	/* enable interrupt */
+	hw_interrupt_enable(temp);
+
+	/* do schedule */
+	sk_schedule();
+
+	return SK_EOK;
+}
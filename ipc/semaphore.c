@@ -10,6 +10,7 @@
  *  published by the Free Software Foundation.
  * */
 #include <ipc.h>
+#include <atomic.h>
 
 extern sk_err_t __ipc_list_resume_all(sk_list_t *list);
 extern sk_err_t __ipc_object_init(struct sk_ipc_object *ipc);
@@ -17,6 +18,60 @@ extern sk_err_t __ipc_list_suspend(sk_list_t *list,
 									  struct sk_thread *thread,
 									  sk_uint8_t flag);
 
+/*
+ * __sem_take
+ * brief
+ * 		take one count if the semaphore has any, by exclusive load/store
+ * 		without masking interrupts. relies on the mmu being on, so that the
+ * 		count is in normal cacheable memory
+ * param
+ * 		sem: pointer to semaphore
+ */
+static inline sk_bool_t __sem_take(struct sk_sem *sem)
+{
+	sk_uint16_t value, old;
+
+	value = sem->value;
+	while(value > 0) {
+		old = sk_atomic_cmpxchg16_acquire(&sem->value, value, value - 1);
+		if(old == value)
+			return SK_TRUE;
+		value = old;
+	}
+
+	return SK_FALSE;
+}
+
+/*
+ * __sem_give
+ * brief
+ * 		give one count back by exclusive load/store. threads wait only while
+ * 		the value is 0, a value not less than floor means there is nobody
+ * 		to wake up
+ * param
+ * 		sem: pointer to semaphore
+ * 		floor: the lowest value the count can be given to
+ * return
+ * 		SK_EBUSY if the value is below floor
+ */
+static inline sk_err_t __sem_give(struct sk_sem *sem, sk_uint16_t floor)
+{
+	sk_uint16_t value, old;
+
+	value = sem->value;
+	while(value >= floor) {
+		if(value >= SK_SEM_VALUE_MAX)
+			return SK_EFULL;
+
+		old = sk_atomic_cmpxchg16_release(&sem->value, value, value + 1);
+		if(old == value)
+			return SK_EOK;
+		value = old;
+	}
+
+	return SK_EBUSY;
+}
+
 /*
  * sk_sem_init
  * brief
@@ -109,18 +164,18 @@ sk_err_t sk_sem_wait(struct sk_sem *sem, sk_int32_t time)
 	struct sk_thread *thread;
 	sk_ubase_t temp;
 
+	/* fast path, the semaphore is available */
+	if(__sem_take(sem))
+		return SK_EOK;
+
 	/* get current thread */
 	thread = sk_current_thread();
 
 	/* disable interrupt */	
 	temp = hw_interrupt_disable();
 
-	/* the value of mutex is 1 in initial status. therefore, if the value
-	 * is great thann 0, it indicates the mutex is avaible */
-	if(sem->value > 0) {
-		/* sem is available */
-		sem->value --;
-
+	/* a count may be given back before interrupt is disabled */
+	if(__sem_take(sem)) {
 		/* enable interrupt */
 		hw_interrupt_enable(temp);
 	} else {
@@ -181,9 +236,12 @@ sk_err_t sk_sem_post(struct sk_sem *sem)
 {
 	struct sk_thread *thread;
 	sk_ubase_t temp;
+	sk_err_t ret;
 
-	/* get current thread */
-	thread = sk_current_thread();
+	/* fast path, the value is not 0 so no thread is waiting */
+	ret = __sem_give(sem, 1);
+	if(ret != SK_EBUSY)
+		return ret;
 
 	/* disable interrupt */	
 	temp = hw_interrupt_disable();
@@ -207,18 +265,12 @@ sk_err_t sk_sem_post(struct sk_sem *sem)
 
 		return SK_EOK;
 	} else {
-		if(sem->value < SK_SEM_VALUE_MAX) {
-			sem->value ++;
-		} else {
-			/* enable interrupt */
-			hw_interrupt_enable(temp);
-			return SK_EFULL;
-		}
+		ret = __sem_give(sem, 0);
 	}
 
 	/* enable interrupt */
 	hw_interrupt_enable(temp);
 
-	return SK_EOK;
+	return ret;
 }
 
@@ -13,7 +13,10 @@ QEMU=qemu-system-aarch64
 KERNEL_IMAGE=build_out/kernel
 RAM_SIZE=256
 CORE_TYPE=cortex-a53
-CORE_NUM=1
+# number of cores, set 2 or more when kernel is built with SK_CPUS_NR > 1
+CORE_NUM=${CORE_NUM:-1}
+# gic version of virt machine, set 3 when kernel is built with SK_USING_GICV3
+GIC_VERSION=${GIC_VERSION:-2}
 
 if [ -z $(which qemu-system-aarch64) ];then
 	echo "please install qemu-system-aarch64 tools"
@@ -31,7 +34,7 @@ fi
 if [ $# -eq 1 ];then
 if [ $1 == "-d" ];then
 sudo ${QEMU} \
-    -M virt \
+    -M virt,gic-version=${GIC_VERSION} \
     -m ${RAM_SIZE} \
     -cpu ${CORE_TYPE} \
     -smp ${CORE_NUM} \
@@ -41,7 +44,7 @@ sudo ${QEMU} \
 fi
 else
 sudo ${QEMU} \
-    -M virt \
+    -M virt,gic-version=${GIC_VERSION} \
     -m ${RAM_SIZE} \
     -cpu ${CORE_TYPE} \
     -smp ${CORE_NUM} \
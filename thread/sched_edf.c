@@ -0,0 +1,290 @@
+/*
+ *  sched_edf.c
+ *  brief
+ *  	earliest deadline first scheduling class
+ *
+ *  (C) 2025.04.02 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+#include <interrupt.h>
+#include <skernel.h>
+#include <hw.h>
+#include <klist.h>
+#include <sched.h>
+#include <config.h>
+
+extern struct sk_thread *__thread_create(const char *name,
+										 void (*entry)(void *param),
+										 void *param,
+										 sk_uint32_t stack_size,
+										 sk_uint8_t priority,
+										 sk_uint32_t tick);
+
+/* total density reserved by admitted deadline threads, per-mille */
+static sk_uint32_t edf_total_bw = 0;
+
+/*
+ * __edf_bandwidth
+ * brief
+ * 		calculate the density of a deadline thread, runtime / min(deadline,
+ * 		period), round up. with constrained deadline the utilization
+ * 		runtime / period is not a sufficient test, the density is
+ * param
+ * 		runtime: budget of each period
+ * 		deadline: relative deadline
+ * 		period: activation period
+ */
+static sk_uint32_t __edf_bandwidth(sk_tick_t runtime, sk_tick_t deadline, sk_tick_t period)
+{
+	sk_tick_t window = (deadline < period) ? deadline : period;
+
+	return (runtime * 1000 + window - 1) / window;
+}
+
+/*
+ * sk_sched_edf_bandwidth
+ * brief
+ * 		return the density reserved by all deadline threads, per-mille
+ */
+sk_uint32_t sk_sched_edf_bandwidth(void)
+{
+	return edf_total_bw;
+}
+
+/*
+ * sk_thread_edf_create
+ * brief
+ * 		create a thread of earliest deadline first class. the thread is admitted
+ * 		only if the total reserved density, runtime / min(deadline, period) of
+ * 		all deadline threads, stays below SK_SCHED_EDF_BW_MAX
+ * param
+ * 		name: the name of thread
+ * 		entry: the entry function of thread
+ * 		param: parameter of entry function
+ * 		stack_size: the stack size of thread
+ * 		runtime: the budget of each period in tick
+ * 		deadline: the relative deadline in tick
+ * 		period: the activation period in tick
+ */
+struct sk_thread *sk_thread_edf_create(const char 		*name,
+								   void 			(*entry)(void *param),
+								   void 			*param,
+								   sk_uint32_t 		stack_size,
+								   sk_tick_t 		runtime,
+								   sk_tick_t 		deadline,
+								   sk_tick_t 		period)
+{
+	struct sk_thread *thread;
+	sk_uint32_t bw;
+	sk_base_t level;
+	sk_tick_t now;
+
+	/* runtime <= deadline <= period */
+	if(runtime == 0 || runtime > deadline || deadline > period)
+		return SK_NULL;
+
+	bw = __edf_bandwidth(runtime, deadline, period);
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	/* admission control */
+	if(edf_total_bw + bw > SK_SCHED_EDF_BW_MAX) {
+		/* enable interrupt */
+		hw_interrupt_enable(level);
+		return SK_NULL;
+	}
+	edf_total_bw += bw;
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	thread = __thread_create(name, entry, param, stack_size,
+							 SK_SCHED_EDF_PRIORITY, runtime);
+	if(thread == SK_NULL) {
+		level = hw_interrupt_disable();
+		edf_total_bw -= bw;
+		hw_interrupt_enable(level);
+		return SK_NULL;
+	}
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	/* the thread is not queued yet, set up its deadline first */
+	now = sk_tick_get();
+	thread->edf.runtime 	 = runtime;
+	thread->edf.deadline 	 = deadline;
+	thread->edf.period 		 = period;
+	thread->edf.bandwidth 	 = bw;
+	thread->edf.abs_deadline = now + deadline;
+	thread->edf.budget 		 = runtime;
+	thread->edf.release 	 = now + period;
+	thread->sched_class 	 = SK_SCHED_CLASS_EDF;
+
+	/* insert to schedule ready list */
+	sk_schedule_insert_thread(thread);
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	return thread;
+}
+
+/*
+ * sk_sched_edf_detach
+ * brief
+ * 		give back the bandwidth of a deadline thread
+ * param
+ * 		thread: the deadline thread
+ */
+void sk_sched_edf_detach(struct sk_thread *thread)
+{
+	sk_base_t level;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	edf_total_bw -= thread->edf.bandwidth;
+	thread->edf.bandwidth = 0;
+	thread->sched_class = SK_SCHED_CLASS_RT;
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+}
+
+/*
+ * sk_sched_edf_place
+ * brief
+ * 		cbs wakeup rule of a waking deadline thread. the left budget may be
+ * 		used up to the current deadline only if it fits the reserved density,
+ * 		otherwise, also with a deadline already passed, a new server period
+ * 		starts now. called with interrupt disabled
+ * param
+ * 		thread: the waking deadline thread
+ */
+void sk_sched_edf_place(struct sk_thread *thread)
+{
+	struct sk_sched_edf *edf = &(thread->edf);
+	sk_tick_t now = sk_tick_get();
+
+	if(SK_TICK_BEFORE(now, edf->abs_deadline) &&
+	   (sk_uint64_t)edf->budget * 1000 <=
+	   (sk_uint64_t)(edf->abs_deadline - now) * edf->bandwidth)
+		return;
+
+	edf->abs_deadline = now + edf->deadline;
+	edf->budget = edf->runtime;
+	edf->missed = 0;
+}
+
+/*
+ * sk_sched_edf_tick
+ * brief
+ * 		account one tick to the running deadline thread. this is the constant
+ * 		bandwidth server: when the budget is exhausted, the deadline is postponed
+ * 		by one period, the budget is refilled and the thread is throttled until
+ * 		the old deadline. called by sk_tick_increase() with interrupt disabled
+ * param
+ * 		thread: current running deadline thread
+ * return
+ * 		SK_TRUE if a reschedule is needed
+ */
+sk_bool_t sk_sched_edf_tick(struct sk_thread *thread)
+{
+	struct sk_sched_edf *edf = &(thread->edf);
+	sk_tick_t now = sk_tick_get();
+	sk_tick_t replenish, tick;
+
+	/* the job is still running after its deadline */
+	if(!edf->missed && SK_TICK_BEFORE(edf->abs_deadline, now)) {
+		edf->missed = 1;
+		edf->miss++;
+	}
+
+	if(edf->budget > 0)
+		edf->budget--;
+	if(edf->budget > 0)
+		return SK_FALSE;
+
+	/* budget exhausted, postpone deadline and refill budget. a miss of
+	 * the postponed deadline is counted again */
+	replenish = edf->abs_deadline;
+	edf->abs_deadline += edf->period;
+	edf->budget = edf->runtime;
+	edf->missed = 0;
+
+	/* throttle the thread until replenishment time */
+	if(SK_TICK_BEFORE(now, replenish)) {
+		edf->throttle++;
+		sk_thread_suspend(thread);
+
+		tick = replenish - now;
+		sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &tick);
+		sk_timer_start(&(thread->thread_timer));
+	}
+
+	/* deadline has changed, let scheduler compare again */
+	return SK_TRUE;
+}
+
+/*
+ * sk_thread_edf_wait_period
+ * brief
+ * 		current deadline thread finishes its job and sleeps until the next
+ * 		release, the new job is set up before sleeping so that the thread is
+ * 		queued with its new deadline when woken up. the deadline never moves
+ * 		earlier than the one of the server
+ */
+sk_err_t sk_thread_edf_wait_period(void)
+{
+	struct sk_thread *thread;
+	struct sk_sched_edf *edf;
+	sk_base_t level;
+	sk_tick_t now, release;
+
+	thread = sk_current_thread();
+	if(thread->sched_class != SK_SCHED_CLASS_EDF)
+		return SK_EINVAL;
+
+	edf = &(thread->edf);
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	now = sk_tick_get();
+
+	/* the job finished after its deadline */
+	if(!edf->missed && SK_TICK_BEFORE(edf->abs_deadline, now))
+		edf->miss++;
+
+	/* set up the next job. a server deadline postponed by an overrun is
+	 * kept with its budget, the budget is refilled only once the server
+	 * deadline is reached, otherwise the reserved density is exceeded */
+	release = edf->release;
+	if(!SK_TICK_BEFORE(release + edf->deadline, edf->abs_deadline)) {
+		edf->abs_deadline = release + edf->deadline;
+		edf->budget = edf->runtime;
+	}
+	edf->release = release + edf->period;
+	edf->missed = 0;
+
+	/* overrun, the job runs on at once, as if it was woken up now */
+	if(!SK_TICK_BEFORE(now, release))
+		sk_sched_edf_place(thread);
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	/* overrun, the next job is already released */
+	if(!SK_TICK_BEFORE(now, release)) {
+		/* deadline has changed, let scheduler compare again */
+		sk_schedule();
+		return SK_EOK;
+	}
+
+	return sk_thread_sleep(release - now);
+}
@@ -0,0 +1,171 @@
+/*
+ *  sched_fair.c
+ *  brief
+ *  	weighted fair share scheduling class
+ *
+ *  (C) 2025.04.08 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ */
+#include <interrupt.h>
+#include <skernel.h>
+#include <hw.h>
+#include <klist.h>
+#include <sched.h>
+#include <config.h>
+
+/* fixed point shift of virtual runtime */
+#define SK_SCHED_FAIR_SHIFT 		(10)
+
+extern sk_list_t sk_thread_prio_table[SK_THREAD_PRIORITY_MAX];
+extern struct sk_thread *__thread_create(const char *name,
+										 void (*entry)(void *param),
+										 void *param,
+										 sk_uint32_t stack_size,
+										 sk_uint8_t priority,
+										 sk_uint32_t tick);
+
+/* smallest virtual runtime of the fair band, never goes backwards */
+static sk_uint64_t fair_min_vruntime = 0;
+
+/*
+ * __fair_delta
+ * brief
+ * 		convert real ticks to virtual runtime, heavier thread runs slower
+ * param
+ * 		weight: weight of the thread
+ * 		tick: real ticks
+ */
+static sk_uint64_t __fair_delta(sk_uint32_t weight, sk_tick_t tick)
+{
+	return ((sk_uint64_t)tick * SK_SCHED_FAIR_WEIGHT << SK_SCHED_FAIR_SHIFT) / weight;
+}
+
+/*
+ * __fair_first
+ * brief
+ * 		return the ready fair thread with smallest virtual runtime
+ */
+static struct sk_thread *__fair_first(void)
+{
+	sk_list_t *list = &sk_thread_prio_table[SK_SCHED_FAIR_PRIORITY];
+
+	if(sk_list_empty(list))
+		return SK_NULL;
+
+	return sk_list_entry(list->next, struct sk_thread, tlist);
+}
+
+/*
+ * sk_sched_fair_min_vruntime
+ * brief
+ * 		return the virtual time of the fair band
+ */
+sk_uint64_t sk_sched_fair_min_vruntime(void)
+{
+	return fair_min_vruntime;
+}
+
+/*
+ * sk_thread_fair_create
+ * brief
+ * 		create a thread of the fair share class. all fair threads share the
+ * 		SK_SCHED_FAIR_PRIORITY band and get cpu time in proportion to weight
+ * param
+ * 		name: the name of thread
+ * 		entry: the entry function of thread
+ * 		param: parameter of entry function
+ * 		stack_size: the stack size of thread
+ * 		weight: the weight of thread, SK_SCHED_FAIR_WEIGHT is the default
+ */
+struct sk_thread *sk_thread_fair_create(const char 		*name,
+									void 			(*entry)(void *param),
+									void 			*param,
+									sk_uint32_t 		stack_size,
+									sk_uint32_t 		weight)
+{
+	struct sk_thread *thread;
+	sk_base_t level;
+
+	if(weight == 0)
+		return SK_NULL;
+
+	thread = __thread_create(name, entry, param, stack_size,
+							 SK_SCHED_FAIR_PRIORITY, SK_SCHED_FAIR_GRANULARITY);
+	if(thread == SK_NULL)
+		return SK_NULL;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	/* the thread is not queued yet, set up its weight first */
+	thread->fair.weight 	= weight;
+	thread->fair.vruntime 	= 0;
+	thread->fair.exec_tick 	= 0;
+	thread->sched_class 	= SK_SCHED_CLASS_FAIR;
+
+	/* insert to schedule ready list by its virtual runtime */
+	sk_schedule_insert_thread(thread);
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+
+	return thread;
+}
+
+/*
+ * sk_sched_fair_place
+ * brief
+ * 		place a waking fair thread on the virtual time line. a thread that
+ * 		slept for long starts from the current virtual time, so it can't
+ * 		starve the others with the credit of its sleep
+ * param
+ * 		thread: the waking fair thread
+ */
+void sk_sched_fair_place(struct sk_thread *thread)
+{
+	if(thread->fair.vruntime < fair_min_vruntime)
+		thread->fair.vruntime = fair_min_vruntime;
+}
+
+/*
+ * sk_sched_fair_tick
+ * brief
+ * 		account one tick to the running fair thread. the thread is preempted
+ * 		when the first ready fair thread is behind it by more than the
+ * 		granularity. called by sk_tick_increase() with interrupt disabled
+ * param
+ * 		thread: current running fair thread
+ * return
+ * 		SK_TRUE if a reschedule is needed
+ */
+sk_bool_t sk_sched_fair_tick(struct sk_thread *thread)
+{
+	struct sk_thread *next;
+	sk_uint64_t vruntime;
+
+	thread->fair.exec_tick++;
+	thread->fair.vruntime += __fair_delta(thread->fair.weight, 1);
+
+	/* advance virtual time of the band */
+	vruntime = thread->fair.vruntime;
+	next = __fair_first();
+	if(next != SK_NULL && next->fair.vruntime < vruntime)
+		vruntime = next->fair.vruntime;
+	if(vruntime > fair_min_vruntime)
+		fair_min_vruntime = vruntime;
+
+	if(next == SK_NULL)
+		return SK_FALSE;
+
+	/* run at least the granularity to avoid switching every tick */
+	if(next->fair.vruntime + __fair_delta(SK_SCHED_FAIR_WEIGHT, SK_SCHED_FAIR_GRANULARITY)
+	   >= thread->fair.vruntime)
+		return SK_FALSE;
+
+	thread->stat |= SK_THREAD_YIELD;
+
+	return SK_TRUE;
+}
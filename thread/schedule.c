@@ -14,33 +14,173 @@
 #include <hw.h>
 #include <klist.h>
 #include <sched.h>
+#include <config.h>
 
 /* schedule management data structure */
 sk_list_t sk_thread_prio_table[SK_THREAD_PRIORITY_MAX];
-struct sk_thread *current_thread = SK_NULL;
 sk_uint32_t sk_thread_ready_prio_group;
+struct sk_cpu sk_cpus[SK_CPUS_NR];
 
 /*
  * __schedule_get_hp_thread
  * brief
- * 		find the highest priority ready thread
+ * 		find the highest priority ready thread allowed to run on the cpu. the
+ * 		head of the highest ready list is taken in the common case, threads
+ * 		bound to other cpus are skipped
  * param
+ * 		cpu: scheduler data of current cpu
  * 		highest_prio: the highest priority
  */
-static struct sk_thread *__schedule_get_hp_thread(sk_ubase_t *highest_prio)
+static struct sk_thread *__schedule_get_hp_thread(struct sk_cpu *cpu, sk_ubase_t *highest_prio)
 {
 	struct sk_thread *thread;
 	sk_ubase_t ready_prio;
+	sk_uint32_t group = sk_thread_ready_prio_group;
+	sk_list_t *n;
+
+	while(group != 0) {
+		ready_prio = __sk_ffs(group) - 1;
+
+		/* get highest ready priority thread */
+		sk_list_for_each(n, &sk_thread_prio_table[ready_prio]) {
+			thread = sk_list_entry(n, struct sk_thread, tlist);
+			if(thread->cpus_allowed & (1U << cpu->id)) {
+				*highest_prio = ready_prio;
+				return thread;
+			}
+		}
+
+		group &= ~(1U << ready_prio);
+	}
+
+	return SK_NULL;
+}
+
+/*
+ * __schedule_ordered
+ * brief
+ * 		check whether the ready list of thread is ordered by its class. a
+ * 		deadline or fair thread boosted out of its band by priority
+ * 		inheritance is queued as fixed priority thread
+ * param
+ * 		thread: the thread to be checked
+ */
+static sk_bool_t __schedule_ordered(struct sk_thread *thread)
+{
+	return thread->sched_class != SK_SCHED_CLASS_RT &&
+		   thread->current_pri == thread->init_pri;
+}
+
+/*
+ * __schedule_thread_before
+ * brief
+ * 		check whether thread a should run before thread b of the same band.
+ * 		threads boosted into the band by priority inheritance run first in
+ * 		fifo order, deadline threads are ordered by absolute deadline and
+ * 		fair threads by virtual runtime
+ * param
+ * 		a: the thread to be compared
+ * 		b: the thread to be compared with
+ */
+static sk_bool_t __schedule_thread_before(struct sk_thread *a, struct sk_thread *b)
+{
+	if(!__schedule_ordered(b))
+		return SK_FALSE;
+	if(!__schedule_ordered(a))
+		return SK_TRUE;
+
+	if(a->sched_class == SK_SCHED_CLASS_EDF)
+		return SK_TICK_BEFORE(a->edf.abs_deadline, b->edf.abs_deadline);
+
+	return a->fair.vruntime < b->fair.vruntime;
+}
+
+/*
+ * __schedule_insert_ordered
+ * brief
+ * 		insert a thread to its ready list, the list is kept sorted so that
+ * 		the head is always the one should run first
+ * param
+ * 		list: ready list of the priority band
+ * 		thread: the thread to be inserted
+ */
+static void __schedule_insert_ordered(sk_list_t *list, struct sk_thread *thread)
+{
+	sk_list_t *n;
+	struct sk_thread *t;
+
+	/* find the first thread should run after it */
+	for(n = list->next; n != list; n = n->next) {
+		t = sk_list_entry(n, struct sk_thread, tlist);
+		if(__schedule_thread_before(thread, t))
+			break;
+	}
+
+	/* insert before it, or at the tail if not found */
+	sk_list_add_tail(n, &(thread->tlist));
+}
+
+/*
+ * __schedule_keep_current
+ * brief
+ * 		check whether current running thread should keep the cpu
+ * param
+ * 		cpu: scheduler data of current cpu
+ * 		to_thread: the highest priority ready thread
+ * 		ready_prio: priority of to_thread
+ */
+static sk_bool_t __schedule_keep_current(struct sk_cpu *cpu, struct sk_thread *to_thread,
+										 sk_ubase_t ready_prio)
+{
+	struct sk_thread *current = cpu->current_thread;
+
+	if((current->stat & SK_THREAD_MASK) != SK_THREAD_RUNNING)
+		return SK_FALSE;
+
+	/* affinity changed, current thread must leave this cpu */
+	if(!(current->cpus_allowed & (1U << cpu->id)))
+		return SK_FALSE;
+
+	/* higher priority thread is ready */
+	if(ready_prio < current->current_pri)
+		return SK_FALSE;
+
+	/* lower priority thread is ready */
+	if(ready_prio > current->current_pri)
+		return SK_TRUE;
 
-	ready_prio = __sk_ffs(sk_thread_ready_prio_group) - 1;
+	/* same band, deadline threads are ordered by absolute deadline */
+	if(current->sched_class == SK_SCHED_CLASS_EDF &&
+	   __schedule_ordered(current) && __schedule_ordered(to_thread))
+		return !__schedule_thread_before(to_thread, current);
 
-	/* get highest ready priority thread */
-	thread = sk_list_entry(sk_thread_prio_table[ready_prio].next,
-						   struct sk_thread, tlist);
-	*highest_prio = ready_prio;
+	/* same band, time slice is over or fair share is used up */
+	return !(current->stat & SK_THREAD_YIELD);
+}
+
+#ifdef SK_USING_STACK_CHECK
+/*
+ * __schedule_stack_check
+ * brief
+ * 		cheap overflow check of a thread at context switch: the stack
+ * 		pointer must be inside the stack and the bottom word must still
+ * 		hold the paint pattern
+ * param
+ * 		thread: the thread to be checked
+ * 		sp: stack pointer of the thread
+ */
+static void __schedule_stack_check(struct sk_thread *thread, sk_ubase_t sp)
+{
+	sk_ubase_t bottom = (sk_ubase_t)thread->stack_addr;
 
-	return thread;
+	if(*(sk_uint32_t *)bottom != SK_THREAD_STACK_MAGIC ||
+	   sp <= bottom || sp > bottom + thread->stack_size) {
+		sk_kprintf("thread %s stack overflow, sp: 0x%x, stack: 0x%x, size: %d\n",
+				   thread->name, sp, bottom, thread->stack_size);
+		while(1);
+	}
 }
+#endif
 
 /*
  * sk_schedule_remove_thread
@@ -80,15 +220,32 @@ void sk_schedule_insert_thread(struct sk_thread *thread)
 	level = hw_interrupt_disable();
 	
 	/* if thread is current running thread, break */
-	if(thread == current_thread) {
+	if(thread == sk_cpu_self()->current_thread) {
 		thread->stat = SK_THREAD_RUNNING;
+		/* enable interrupt */
+		hw_interrupt_enable(level);
 		return;
 	}
 
+	/* waking fair thread can't bring back credit of its sleep time */
+	if(thread->sched_class == SK_SCHED_CLASS_FAIR &&
+	   (thread->stat & SK_THREAD_MASK) != SK_THREAD_RUNNING)
+		sk_sched_fair_place(thread);
+
+	/* waking deadline thread can't run on a stale deadline or budget */
+	if(thread->sched_class == SK_SCHED_CLASS_EDF &&
+	   (thread->stat & SK_THREAD_MASK) != SK_THREAD_RUNNING)
+		sk_sched_edf_place(thread);
+
 	/* set thread stat to be ready */
 	thread->stat = SK_THREAD_READY;
-	/* insert it to list head tail */
-	sk_list_add_tail(&(sk_thread_prio_table[thread->current_pri]), &(thread->tlist));
+	if(SK_SCHED_CLASS_BAND(thread->current_pri)) {
+		/* band of deadline or fair class, insert in order */
+		__schedule_insert_ordered(&(sk_thread_prio_table[thread->current_pri]), thread);
+	} else {
+		/* insert it to list head tail */
+		sk_list_add_tail(&(sk_thread_prio_table[thread->current_pri]), &(thread->tlist));
+	}
 	/* set priority mask */
 	sk_thread_ready_prio_group |= thread->number_mask;
 
@@ -112,6 +269,11 @@ void sk_system_scheduler_init(void)
 		sk_list_init(&sk_thread_prio_table[index]);
 	}
 
+	for(index = 0; index < SK_CPUS_NR; index++) {
+		sk_cpus[index].id = index;
+		sk_cpus[index].current_thread = SK_NULL;
+	}
+
 	/* initialize ready priority group */
 	sk_thread_ready_prio_group = 0;
 
@@ -119,48 +281,168 @@ void sk_system_scheduler_init(void)
 	hw_interrupt_enable(level);
 }
 
+/*
+ * sk_cpu_self
+ * brief
+ * 		return the scheduler data of current cpu
+ */
+struct sk_cpu *sk_cpu_self(void)
+{
+	return &sk_cpus[hw_cpu_id()];
+}
+
+/*
+ * __schedule
+ * brief
+ * 		select one thread with the highest priority, and switch to it.
+ * 		called with interrupt disabled
+ * param
+ * 		cpu: scheduler data of current cpu
+ */
+static void __schedule(struct sk_cpu *cpu)
+{
+	sk_ubase_t ready_hp_prio;
+	struct sk_thread *to_thread, *from_thread;
+
+	cpu->schedule_count++;
+
+	if(sk_thread_ready_prio_group == 0)
+		return;
+
+	to_thread = __schedule_get_hp_thread(cpu, &ready_hp_prio);		
+	/* no preemption if ready thread can't beat curent thread */
+	if(to_thread == SK_NULL || __schedule_keep_current(cpu, to_thread, ready_hp_prio)) {
+		cpu->current_thread->stat &= ~SK_THREAD_YIELD;
+		return;
+	}
+
+	from_thread  = cpu->current_thread;
+	cpu->current_thread = to_thread;
+	/* insert thread to ready list */
+	if(from_thread->stat != SK_THREAD_SUSPEND && from_thread->stat != SK_THREAD_CLOSE)
+		sk_schedule_insert_thread(from_thread);
+	to_thread->stat &= ~SK_THREAD_YIELD;
+	/* remove thread from ready list */
+	sk_schedule_remove_thread(to_thread);
+	/* change thread status */
+	to_thread->stat = SK_THREAD_RUNNING;
+	to_thread->oncpu = cpu->id;
+
+	cpu->switch_count++;
+
+#ifdef SK_USING_STACK_CHECK
+	/* from_thread->sp is not saved yet, check the live one. the saved
+	 * sp of to_thread is the one about to be restored */
+	__schedule_stack_check(from_thread, hw_thread_sp());
+	__schedule_stack_check(to_thread, (sk_ubase_t)to_thread->sp);
+#endif
+
+	/* thread context switch */
+	if(sk_is_in_interrupt())
+		hw_context_switch_interrupt((sk_ubase_t)&from_thread->sp,
+							 (sk_ubase_t)&to_thread->sp);
+	else
+		hw_context_switch((sk_ubase_t)&from_thread->sp,
+							 (sk_ubase_t)&to_thread->sp);
+}
+
 /*
  * sk_schedule
  * brief
- * 		select one thread with the highest priority, and switch to it 
+ * 		select one thread with the highest priority, and switch to it. in
+ * 		interrupt context only a reschedule request is made, the scheduler
+ * 		runs once when the outermost interrupt exits
  */
 void sk_schedule(void)
 {
 	sk_base_t level;
-	sk_ubase_t ready_hp_prio;
-	struct sk_thread *to_thread, *from_thread;
+	struct sk_cpu *cpu;
 
 	/* disable interrupt */
 	level = hw_interrupt_disable();
 
-	if(sk_thread_ready_prio_group != 0) {
-		to_thread = __schedule_get_hp_thread(&ready_hp_prio);		
-		if(current_thread->stat == SK_THREAD_RUNNING) {
-			/* preemption if ready thread's priority lower then curent thread */
-			if(current_thread->current_pri <= ready_hp_prio)
-				to_thread = current_thread;
-		}
-		/* if the destination thread is not same as current thread */
-		if(current_thread != to_thread) {
-			from_thread  = current_thread;
-			current_thread = to_thread;
-			/* insert thread to ready list */
-			if(from_thread->stat != SK_THREAD_SUSPEND && from_thread->stat != SK_THREAD_CLOSE)
-				sk_schedule_insert_thread(from_thread);
-			current_thread->stat &= ~SK_THREAD_YIELD;
-			/* remove thread from ready list */
-			sk_schedule_remove_thread(to_thread);
-			/* change thread status */
-			to_thread->stat = SK_THREAD_RUNNING;
-
-			/* thread context switch */
-			if(sk_is_in_interrupt())
-				hw_context_switch_interrupt((sk_ubase_t)&from_thread->sp,
-									 (sk_ubase_t)&to_thread->sp);
-			else
-				hw_context_switch((sk_ubase_t)&from_thread->sp,
-									 (sk_ubase_t)&to_thread->sp);
-		}
+	cpu = sk_cpu_self();
+	if(cpu->irq_nest != 0 || cpu->sched_lock_nest != 0) {
+		cpu->need_resched = 1;
+		cpu->resched_request++;
+	} else {
+		cpu->need_resched = 0;
+		__schedule(cpu);
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+}
+
+/*
+ * sk_schedule_irq_exit
+ * brief
+ * 		called by vector_irq before leaving interrupt, do the reschedule
+ * 		requested during the interrupt
+ *
+ * 		note: don't invoke this function in application
+ */
+void sk_schedule_irq_exit(void)
+{
+	sk_base_t level;
+	struct sk_cpu *cpu;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	cpu = sk_cpu_self();
+	/*
+	 * only the outermost interrupt can switch thread, a secondary cpu
+	 * serving ipis only has no thread to switch from
+	 */
+	if(cpu->need_resched && cpu->irq_nest == 1 && cpu->sched_lock_nest == 0 &&
+	   cpu->current_thread != SK_NULL) {
+		cpu->need_resched = 0;
+		__schedule(cpu);
+	}
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+}
+
+/*
+ * sk_sched_lock
+ * brief
+ * 		forbid thread switch on current cpu while interrupt keeps enabled,
+ * 		the reschedule is deferred until the last sk_sched_unlock(). can be
+ * 		nested, the locked section must not block
+ */
+void sk_sched_lock(void)
+{
+	sk_base_t level;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	sk_cpu_self()->sched_lock_nest++;
+
+	/* enable interrupt */
+	hw_interrupt_enable(level);
+}
+
+/*
+ * sk_sched_unlock
+ * brief
+ * 		allow thread switch again, do the reschedule requested while locked
+ */
+void sk_sched_unlock(void)
+{
+	sk_base_t level;
+	struct sk_cpu *cpu;
+
+	/* disable interrupt */
+	level = hw_interrupt_disable();
+
+	cpu = sk_cpu_self();
+	cpu->sched_lock_nest--;
+	if(cpu->sched_lock_nest == 0 && cpu->need_resched && cpu->irq_nest == 0) {
+		cpu->need_resched = 0;
+		__schedule(cpu);
 	}
 
 	/* enable interrupt */
@@ -175,16 +457,18 @@ void sk_schedule(void)
 void sk_system_scheduler_start(void)
 {
 	struct sk_thread *to_thread;
+	struct sk_cpu *cpu = sk_cpu_self();
 	sk_ubase_t prio;
 
-	to_thread = __schedule_get_hp_thread(&prio);
+	to_thread = __schedule_get_hp_thread(cpu, &prio);
 
 	/* set current thread */
-	current_thread = to_thread;
+	cpu->current_thread = to_thread;
 	/* remove thread from ready list */
 	sk_schedule_remove_thread(to_thread);
 	/* change thread status to RUNNING */
 	to_thread->stat = SK_THREAD_RUNNING;
+	to_thread->oncpu = cpu->id;
 
 	/* set thread context */
 	hw_context_switch_to((sk_ubase_t)&to_thread->sp);
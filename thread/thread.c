@@ -16,11 +16,17 @@
 #include <sched.h>
 
 #define INITIAL_SPSR_EL1			(0x04)
-#define SK_IDLE_THREAD_STACK_SIZE 	(128)
+#define SK_IDLE_THREAD_STACK_SIZE 	(512)
 #define SK_IDLE_THREAD_TICK 		(32)
 
 static sk_tick_t idle_tick = 10;
 
+extern void __mutex_update_prio(struct sk_thread *thread);
+
+/* idle thread is placed statically */
+static struct sk_thread idle_thread;
+static sk_uint8_t idle_thread_stack[SK_IDLE_THREAD_STACK_SIZE] ALIGN(16);
+
 
 /*
  * __thread_stack_init
@@ -87,9 +93,7 @@ static sk_uint8_t *__thread_stack_init(void *entry,void *param,
  * */
 struct sk_thread* sk_current_thread(void)
 {
-	extern struct sk_thread *current_thread;
-
-	return current_thread;
+	return sk_cpu_self()->current_thread;
 }
 
 /*
@@ -107,6 +111,9 @@ void sk_thread_timeout(void *param)
 	/* disable interrupt */
 	level = hw_interrupt_disable();
 
+	/* the blocking wait is over without result */
+	thread->error = SK_ETIMEOUT;
+
 	/* remove from suspend list */
 	sk_list_del(&(thread->tlist));
 
@@ -143,6 +150,10 @@ static void __thread_exit(void)
 	/* remove from schedule */
 	sk_schedule_remove_thread(thread);
 
+	/* give back the reserved bandwidth of deadline thread */
+	if(thread->sched_class == SK_SCHED_CLASS_EDF)
+		sk_sched_edf_detach(thread);
+
 	/* change thread state */
 	thread->stat = SK_THREAD_CLOSE;
 
@@ -195,6 +206,9 @@ static sk_err_t __thread_init(struct sk_thread 	*thread,
 	thread->stack_addr = stack_start;
 	thread->stack_size = stack_size;
 
+	/* paint the whole stack, untouched part tells the high-water mark */
+	sk_memset(thread->stack_addr, SK_THREAD_STACK_MAGIC & 0xFF, thread->stack_size);
+
 	/* init thread stack */
 	thread->sp = (void *)__thread_stack_init(thread->entry, thread->param,
 										(sk_uint8_t *)((char *)thread->stack_addr + thread->stack_size - sizeof(sk_ubase_t)),
@@ -202,11 +216,21 @@ static sk_err_t __thread_init(struct sk_thread 	*thread,
 
 	/* priority init */
 	thread->init_pri = priority;
+	thread->base_pri = priority;
 	thread->current_pri = priority; 
 
 	/* set priority attribute */
 	thread->number_mask = 1 << thread->current_pri;
 
+	/* may run on any cpu */
+	thread->cpus_allowed = SK_CPU_MASK_ALL;
+	thread->oncpu = 0;
+
+	/* fixed priority class by default */
+	thread->sched_class = SK_SCHED_CLASS_RT;
+	sk_memset(&(thread->edf), 0, sizeof(struct sk_sched_edf));
+	sk_memset(&(thread->fair), 0, sizeof(struct sk_sched_fair));
+
 	/* init thread state and tick */
 	thread->init_tick = tick;
 	thread->remain_tick = tick;
@@ -219,18 +243,22 @@ static sk_err_t __thread_init(struct sk_thread 	*thread,
 	/* set cleanup function and userdata */
 	thread->cleanup = SK_NULL;
 	thread->user_data = 0;
-		
-	/* insert to schedule ready list */
-	sk_schedule_insert_thread(thread);
+
+	/* no mutex held or waited */
+	thread->pending_mutex = SK_NULL;
+	sk_list_init(&(thread->taken_mutex_list));
+	thread->error = SK_EOK;
 
 	return SK_EOK;
 }
 
-
 /*
- * sk_thread_create
+ * __thread_create
  * brief
- * 		create a thread object and allocate thread stack memory	
+ * 		create a thread object and allocate thread stack memory, the thread
+ * 		is not inserted to schedule ready list. so that the scheduling class
+ * 		can be set up before the thread is visible to scheduler
+ * 		note: don't invoke this function in application
  * param
  * 		name: the name of thread
  * 		entry: the entry function of thread
@@ -239,12 +267,12 @@ static sk_err_t __thread_init(struct sk_thread 	*thread,
  * 		priority: the priority of thread
  * 		tick: the time slice if there are same priority thread
  */
-struct sk_thread *sk_thread_create(const char 			*name,
-							   void 				(*entry)(void *param),
-							   void 				*param,
-							   sk_uint32_t 			stack_size,
-							   sk_uint8_t 			priority,
-							   sk_uint32_t 			tick)
+struct sk_thread *__thread_create(const char 			*name,
+								  void 				(*entry)(void *param),
+								  void 				*param,
+								  sk_uint32_t 			stack_size,
+								  sk_uint8_t 			priority,
+								  sk_uint32_t 			tick)
 {
 	struct sk_thread *thread; 
 	void *stack_start;
@@ -265,6 +293,84 @@ struct sk_thread *sk_thread_create(const char 			*name,
 	return thread;
 }
 
+
+/*
+ * sk_thread_init
+ * brief
+ * 		initialize a thread with caller provided thread object and stack,
+ * 		no memory is allocated. stack should be 16 bytes aligned
+ * param
+ * 		thread: the thread object, usually static
+ * 		name: the name of thread
+ * 		entry: the entry function of thread
+ * 		param: parameter of entry function
+ * 		stack_start: the start address of thread stack
+ * 		stack_size: the stack size of thread
+ * 		priority: the priority of thread, not a band of scheduling class
+ * 		tick: the time slice if there are same priority thread
+ */
+sk_err_t sk_thread_init(struct sk_thread 	*thread,
+						const char 			*name,
+						void 				(*entry)(void *param),
+						void 				*param,
+						void 				*stack_start,
+						sk_uint32_t 		stack_size,
+						sk_uint8_t 			priority,
+						sk_uint32_t 		tick)
+{
+	if(thread == SK_NULL || stack_start == SK_NULL || priority >= SK_THREAD_PRIORITY_MAX)
+		return SK_EINVAL;
+
+	/* the bands of scheduling classes are reserved */
+	if(SK_SCHED_CLASS_BAND(priority))
+		return SK_EINVAL;
+
+	/* add to object system management */
+	sk_object_init((struct sk_object *)thread, SK_OBJECT_THREAD, name);
+
+	__thread_init(thread, name, entry, param, stack_start, stack_size, priority, tick);
+
+	/* insert to schedule ready list */
+	sk_schedule_insert_thread(thread);
+
+	return SK_EOK;
+}
+
+/*
+ * sk_thread_create
+ * brief
+ * 		create a thread object and allocate thread stack memory	
+ * param
+ * 		name: the name of thread
+ * 		entry: the entry function of thread
+ * 		param: parameter of entry function
+ * 		stack_size: the stack size of thread
+ * 		priority: the priority of thread, not a band of scheduling class
+ * 		tick: the time slice if there are same priority thread
+ */
+struct sk_thread *sk_thread_create(const char 			*name,
+							   void 				(*entry)(void *param),
+							   void 				*param,
+							   sk_uint32_t 			stack_size,
+							   sk_uint8_t 			priority,
+							   sk_uint32_t 			tick)
+{
+	struct sk_thread *thread; 
+
+	/* the bands of scheduling classes are reserved */
+	if(priority >= SK_THREAD_PRIORITY_MAX || SK_SCHED_CLASS_BAND(priority))
+		return SK_NULL;
+
+	thread = __thread_create(name, entry, param, stack_size, priority, tick);
+	if(thread == SK_NULL)
+		return SK_NULL;
+
+	/* insert to schedule ready list */
+	sk_schedule_insert_thread(thread);
+
+	return thread;
+}
+
 /*
  * sk_thread_suspend
  * brief
@@ -319,6 +425,9 @@ sk_err_t sk_thread_resume(struct sk_thread *thread)
 	/* remove from suspend list */
 	sk_list_del(&(thread->tlist));
 
+	/* woken up before timeout */
+	sk_timer_stop(&(thread->thread_timer));
+
 	/* insert to scedule ready list */
 	sk_schedule_insert_thread(thread);
 
@@ -373,6 +482,123 @@ sk_err_t sk_thread_suspend(struct sk_thread *thread)
 }
 
 
+/*
+ * sk_thread_control
+ * brief
+ * 		control thread attributes
+ * param
+ * 		thread: the thread to be controlled
+ * 		cmd: control command
+ * 		SK_THREAD_CTRL_CHANGE_PRIORITY: change base priority, arg points to
+ * 		a sk_uint8_t priority. the thread runs at it unless a waiter of a
+ * 		mutex it holds is more urgent. the bands of scheduling classes are
+ * 		rejected
+ * 		SK_THREAD_CTRL_INHERIT_PRIORITY: change current priority, any band is
+ * 		allowed. a ready thread is moved to the new ready list, used by
+ * 		priority inheritance of mutex
+ * 		SK_THREAD_CTRL_BIND_CPU: set the cpus the thread may run on, arg points
+ * 		to a sk_uint32_t mask, bit n for cpu n. the mask must keep a cpu of
+ * 		SK_CPU_MASK_SCHED
+ * 		arg: the argument of command
+ */
+sk_err_t sk_thread_control(struct sk_thread *thread, int cmd, void *arg)
+{
+	sk_base_t level;
+	sk_uint8_t priority;
+	sk_uint32_t mask;
+	sk_bool_t migrate;
+
+	switch(cmd) {
+		case SK_THREAD_CTRL_CHANGE_PRIORITY:
+		case SK_THREAD_CTRL_INHERIT_PRIORITY:
+			priority = *(sk_uint8_t *)arg;
+			if(priority >= SK_THREAD_PRIORITY_MAX)
+				return SK_EINVAL;
+
+			/* only priority inheritance may boost into a class band */
+			if(cmd == SK_THREAD_CTRL_CHANGE_PRIORITY &&
+			   SK_SCHED_CLASS_BAND(priority) && priority != thread->init_pri)
+				return SK_EINVAL;
+
+			/* disable interrupt */
+			level = hw_interrupt_disable();
+
+			if(cmd == SK_THREAD_CTRL_CHANGE_PRIORITY) {
+				/* new base priority, the priority inherited from the waiters
+				 * of held mutexes stays on top of it */
+				thread->base_pri = priority;
+				__mutex_update_prio(thread);
+
+				/* enable interrupt */
+				hw_interrupt_enable(level);
+				break;
+			}
+
+			if((thread->stat & SK_THREAD_MASK) == SK_THREAD_READY) {
+				/* requeue to the ready list of new priority */
+				sk_schedule_remove_thread(thread);
+				thread->current_pri = priority;
+				thread->number_mask = 1 << priority;
+				sk_schedule_insert_thread(thread);
+			} else {
+				thread->current_pri = priority;
+				thread->number_mask = 1 << priority;
+			}
+
+			/* enable interrupt */
+			hw_interrupt_enable(level);
+		break;
+		case SK_THREAD_CTRL_BIND_CPU:
+			mask = *(sk_uint32_t *)arg & SK_CPU_MASK_ALL;
+			/* no cpu left that could run the thread */
+			if(!(mask & SK_CPU_MASK_SCHED))
+				return SK_EINVAL;
+
+			/* disable interrupt */
+			level = hw_interrupt_disable();
+
+			thread->cpus_allowed = mask;
+			migrate = ((thread->stat & SK_THREAD_MASK) == SK_THREAD_RUNNING &&
+					   !(mask & (1U << thread->oncpu)));
+
+			/* enable interrupt */
+			hw_interrupt_enable(level);
+
+			/* running on a cpu it is no longer allowed on, switch it out */
+			if(migrate) {
+				if(thread->oncpu == hw_cpu_id())
+					sk_schedule();
+				else
+					sk_smp_send_reschedule(thread->oncpu);
+			}
+		break;
+		default:
+			return SK_EINVAL;
+	}
+
+	return SK_EOK;
+}
+
+/*
+ * sk_thread_stack_used
+ * brief
+ * 		return the most stack a thread has ever used, in bytes. the painted
+ * 		area is scanned from the stack bottom, stack grows downward
+ * param
+ * 		thread: the thread to be measured
+ */
+sk_uint32_t sk_thread_stack_used(struct sk_thread *thread)
+{
+	sk_uint32_t *bottom = (sk_uint32_t *)thread->stack_addr;
+	sk_uint32_t words = thread->stack_size / sizeof(sk_uint32_t);
+	sk_uint32_t index = 0;
+
+	while(index < words && bottom[index] == SK_THREAD_STACK_MAGIC)
+		index++;
+
+	return thread->stack_size - index * sizeof(sk_uint32_t);
+}
+
 /*
  * sk_thread_sleep
  * brief 
@@ -442,12 +668,14 @@ void sk_thread_idle_init(void)
 {
 	char idle_thread_name[SK_NAME_MAX] = "kidle";
 
-	struct sk_thread *thread = sk_thread_create(idle_thread_name,
-												sk_idle_entry,
-												SK_NULL,
-												SK_IDLE_THREAD_STACK_SIZE,
-												SK_THREAD_PRIORITY_MAX - 1,
-												SK_IDLE_THREAD_TICK);
-	sk_thread_startup(thread);
+	sk_thread_init(&idle_thread,
+				   idle_thread_name,
+				   sk_idle_entry,
+				   SK_NULL,
+				   idle_thread_stack,
+				   SK_IDLE_THREAD_STACK_SIZE,
+				   SK_THREAD_PRIORITY_MAX - 1,
+				   SK_IDLE_THREAD_TICK);
+	sk_thread_startup(&idle_thread);
 }
 
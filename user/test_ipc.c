@@ -282,3 +282,425 @@ void test_msg_queue(void)
 
 SHELL_CMD_EXPORT(test_msg_queue, test case of ipc message queue);
 
+
+#define PI_CRITICAL_TICK 	50
+#define PI_HOG_TICK 		300
+
+static struct sk_mutex pi_mutex;
+
+/* busy loop for the specified ticks of cpu time */
+static void pi_busy_tick(sk_tick_t tick)
+{
+	sk_tick_t last = sk_tick_get();
+
+	while(tick) {
+		if(sk_tick_get() != last) {
+			last = sk_tick_get();
+			tick--;
+		}
+	}
+}
+
+void pi_thread_high(void *param)
+{
+	sk_tick_t start = sk_tick_get();
+
+	sk_mutex_lock(&pi_mutex, -1);
+	sk_kprintf("%s blocked %d ticks, critical section %d ticks\n",
+			   sk_current_thread()->name, sk_tick_get() - start, PI_CRITICAL_TICK);
+	sk_mutex_unlock(&pi_mutex);
+}
+
+void pi_thread_medium(void *param)
+{
+	/* cpu hog between the low and the high priority thread */
+	pi_busy_tick(PI_HOG_TICK);
+	sk_kprintf("%s done\n", sk_current_thread()->name);
+}
+
+void pi_thread_low(void *param)
+{
+	struct sk_thread *thread;
+
+	sk_mutex_lock(&pi_mutex, -1);
+
+	/* high priority thread blocks on the mutex at once */
+	thread = sk_thread_create("pi_high", pi_thread_high, SK_NULL, 2048, 10, 20);
+	sk_thread_startup(thread);
+	sk_kprintf("%s inherits priority %d\n", sk_current_thread()->name,
+			   sk_current_thread()->current_pri);
+
+	/* medium priority thread can't preempt the boosted owner */
+	thread = sk_thread_create("pi_medium", pi_thread_medium, SK_NULL, 2048, 12, 20);
+	sk_thread_startup(thread);
+
+	pi_busy_tick(PI_CRITICAL_TICK);
+	sk_mutex_unlock(&pi_mutex);
+	sk_kprintf("%s restored priority %d\n", sk_current_thread()->name,
+			   sk_current_thread()->current_pri);
+}
+
+void test_mutex_pi(void)
+{
+	struct sk_thread *thread;
+
+	sk_mutex_init(&pi_mutex, "pi_mutex", SK_IPC_FLAG_PRIO);
+
+	thread = sk_thread_create("pi_low", pi_thread_low, SK_NULL, 2048, 14, 20);
+	sk_thread_startup(thread);
+}
+
+SHELL_CMD_EXPORT(test_mutex_pi, test case of mutex priority inheritance);
+
+#define LOCK_BENCH_LOOP 		100000
+
+static sk_uint64_t lock_bench_counter(void)
+{
+	sk_uint64_t cnt;
+
+	__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (cnt));
+
+	return cnt;
+}
+
+void test_lock_bench(void)
+{
+	static struct sk_mutex bench_mutex;
+	static struct sk_sem bench_sem;
+	sk_uint64_t start, freq;
+	sk_uint32_t i, cycles;
+	sk_base_t level;
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+	sk_mutex_init(&bench_mutex, "bench_mutex", SK_IPC_FLAG_PRIO);
+	sk_sem_init(&bench_sem, "bench_sem", 1, SK_IPC_FLAG_FIFO);
+
+	/* cost of the interrupt masking the uncontended path used to take */
+	start = lock_bench_counter();
+	for(i = 0; i < LOCK_BENCH_LOOP; i++) {
+		level = hw_interrupt_disable();
+		hw_interrupt_enable(level);
+	}
+	cycles = lock_bench_counter() - start;
+	sk_kprintf("irq disable/enable: %d ns per pair\n",
+			   (sk_uint32_t)(cycles * 1000000000 / freq / LOCK_BENCH_LOOP));
+
+	start = lock_bench_counter();
+	for(i = 0; i < LOCK_BENCH_LOOP; i++) {
+		sk_mutex_lock(&bench_mutex, -1);
+		sk_mutex_unlock(&bench_mutex);
+	}
+	cycles = lock_bench_counter() - start;
+	sk_kprintf("mutex lock/unlock: %d ns per pair\n",
+			   (sk_uint32_t)(cycles * 1000000000 / freq / LOCK_BENCH_LOOP));
+
+	start = lock_bench_counter();
+	for(i = 0; i < LOCK_BENCH_LOOP; i++) {
+		sk_sem_wait(&bench_sem, -1);
+		sk_sem_post(&bench_sem);
+	}
+	cycles = lock_bench_counter() - start;
+	sk_kprintf("sem wait/post: %d ns per pair\n",
+			   (sk_uint32_t)(cycles * 1000000000 / freq / LOCK_BENCH_LOOP));
+}
+
+SHELL_CMD_EXPORT(test_lock_bench, test case of uncontended mutex and semaphore throughput);
+
+#define RW_BENCH_TICK 			500
+
+static struct sk_rwlock rw_bench_rwlock;
+static struct sk_mutex rw_bench_mutex;
+static struct sk_sem rw_bench_done;
+static sk_tick_t rw_bench_end;
+static sk_bool_t rw_bench_use_mutex;
+static volatile sk_uint32_t rw_bench_count;
+
+void rw_bench_reader(void *param)
+{
+	/* every read section sleeps, readers sharing the lock overlap */
+	while(sk_tick_get() < rw_bench_end) {
+		if(rw_bench_use_mutex) {
+			sk_mutex_lock(&rw_bench_mutex, -1);
+			sk_thread_delay(1);
+			sk_mutex_unlock(&rw_bench_mutex);
+		} else {
+			sk_rwlock_read_lock(&rw_bench_rwlock, -1);
+			sk_thread_delay(1);
+			sk_rwlock_read_unlock(&rw_bench_rwlock);
+		}
+		rw_bench_count++;
+	}
+
+	sk_sem_post(&rw_bench_done);
+}
+
+void rw_bench_thread(void *param)
+{
+	struct sk_thread *thread;
+	sk_uint32_t readers, i, mode;
+
+	for(readers = 1; readers <= 4; readers <<= 1) {
+		for(mode = 0; mode < 2; mode++) {
+			rw_bench_use_mutex = mode;
+			rw_bench_count = 0;
+			rw_bench_end = sk_tick_get() + RW_BENCH_TICK;
+
+			for(i = 0; i < readers; i++) {
+				thread = sk_thread_create("rw_reader", rw_bench_reader, SK_NULL, 2048, 12, 20);
+				sk_thread_startup(thread);
+			}
+			for(i = 0; i < readers; i++)
+				sk_sem_wait(&rw_bench_done, -1);
+
+			sk_kprintf("%d readers, %s: %d read sections in %d ticks\n", readers,
+					   mode ? "mutex" : "rwlock", rw_bench_count, RW_BENCH_TICK);
+		}
+	}
+
+	/* all readers are gone, a writer takes the lock at once */
+	sk_rwlock_write_lock(&rw_bench_rwlock, -1);
+	sk_rwlock_write_unlock(&rw_bench_rwlock);
+	sk_kprintf("rwlock state %x\n", rw_bench_rwlock.state);
+}
+
+void test_rwlock_bench(void)
+{
+	struct sk_thread *thread;
+
+	sk_rwlock_init(&rw_bench_rwlock, "rw_bench", SK_IPC_FLAG_FIFO);
+	sk_mutex_init(&rw_bench_mutex, "rw_mutex", SK_IPC_FLAG_PRIO);
+	sk_sem_init(&rw_bench_done, "rw_done", 0, SK_IPC_FLAG_FIFO);
+
+	thread = sk_thread_create("rw_bench", rw_bench_thread, SK_NULL, 2048, 11, 20);
+	sk_thread_startup(thread);
+}
+
+SHELL_CMD_EXPORT(test_rwlock_bench, test case of rwlock read side scaling against mutex);
+
+#define COND_CONSUMER_NR 		3
+#define COND_ITEM_NR 			12
+
+static struct sk_cond cond_not_empty;
+static struct sk_mutex cond_mutex;
+static sk_uint32_t cond_items;
+static sk_uint32_t cond_consumed;
+
+void cond_consumer(void *param)
+{
+	sk_err_t err;
+
+	sk_mutex_lock(&cond_mutex, -1);
+	while(cond_consumed < COND_ITEM_NR) {
+		while(cond_items == 0) {
+			err = sk_cond_wait(&cond_not_empty, &cond_mutex, 1000);
+			if(err != SK_EOK) {
+				sk_kprintf("%s wait error %d\n", sk_current_thread()->name, err);
+				sk_mutex_unlock(&cond_mutex);
+				return;
+			}
+			if(cond_consumed >= COND_ITEM_NR)
+				break;
+		}
+		if(cond_items) {
+			cond_items--;
+			cond_consumed++;
+			sk_kprintf("%s consumed item %d\n", sk_current_thread()->name, cond_consumed);
+		}
+	}
+	sk_mutex_unlock(&cond_mutex);
+}
+
+void cond_producer(void *param)
+{
+	sk_uint32_t i;
+
+	for(i = 0; i < COND_ITEM_NR; i += COND_CONSUMER_NR) {
+		sk_thread_delay(10);
+
+		/* waiters move to the mutex and run one by one after unlock */
+		sk_mutex_lock(&cond_mutex, -1);
+		cond_items += COND_CONSUMER_NR;
+		sk_cond_broadcast(&cond_not_empty);
+		sk_mutex_unlock(&cond_mutex);
+	}
+
+	/* wake up the consumers waiting for no more items */
+	sk_thread_delay(10);
+	sk_mutex_lock(&cond_mutex, -1);
+	sk_cond_broadcast(&cond_not_empty);
+	sk_mutex_unlock(&cond_mutex);
+}
+
+void test_cond(void)
+{
+	struct sk_thread *thread;
+	sk_uint32_t i;
+
+	cond_items = 0;
+	cond_consumed = 0;
+	sk_mutex_init(&cond_mutex, "cond_mutex", SK_IPC_FLAG_PRIO);
+	sk_cond_init(&cond_not_empty, "not_empty", SK_IPC_FLAG_FIFO);
+
+	for(i = 0; i < COND_CONSUMER_NR; i++) {
+		thread = sk_thread_create("consumer", cond_consumer, SK_NULL, 2048, 12, 20);
+		sk_thread_startup(thread);
+	}
+
+	thread = sk_thread_create("producer", cond_producer, SK_NULL, 2048, 13, 20);
+	sk_thread_startup(thread);
+}
+
+SHELL_CMD_EXPORT(test_cond, test case of ipc condition variable);
+
+#define MQ_BENCH_LOOP 			10000
+
+static const sk_uint32_t mq_bench_size[] = {64, 1024, 4096};
+
+void test_mq_bench(void)
+{
+	struct sk_msg_queue *mq;
+	sk_uint8_t *src, *dst, *slot;
+	sk_uint64_t start, freq;
+	sk_uint32_t i, n, size, check, copy_ns, zero_ns;
+	sk_size_t length;
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+
+	for(n = 0; n < sizeof(mq_bench_size) / sizeof(mq_bench_size[0]); n++) {
+		size = mq_bench_size[n];
+		mq = sk_msg_queue_create("mq_bench", size, 4, SK_IPC_FLAG_FIFO);
+		src = sk_malloc(size);
+		dst = sk_malloc(size);
+		if(mq == SK_NULL || src == SK_NULL || dst == SK_NULL) {
+			sk_kprintf("%d bytes: out of memory\n", size);
+			break;
+		}
+		check = 0;
+
+		/* producer fills a buffer, both sides copy it */
+		start = lock_bench_counter();
+		for(i = 0; i < MQ_BENCH_LOOP; i++) {
+			sk_memset(src, i, size);
+			sk_msg_queue_send(mq, src, size);
+			sk_msg_queue_recv(mq, dst, size, 0);
+			check += dst[size - 1];
+		}
+		copy_ns = (lock_bench_counter() - start) * 1000000000 / freq / MQ_BENCH_LOOP;
+
+		/* producer fills the slot, consumer reads it in place */
+		start = lock_bench_counter();
+		for(i = 0; i < MQ_BENCH_LOOP; i++) {
+			sk_msg_queue_reserve(mq, (void **)&slot, 0);
+			sk_memset(slot, i, size);
+			sk_msg_queue_commit(mq, slot, size);
+			sk_msg_queue_peek(mq, (void **)&slot, &length, 0);
+			check -= slot[length - 1];
+			sk_msg_queue_release(mq, slot);
+		}
+		zero_ns = (lock_bench_counter() - start) * 1000000000 / freq / MQ_BENCH_LOOP;
+
+		sk_kprintf("%d bytes: copy %d ns, zero-copy %d ns per message, check %d\n",
+				   size, copy_ns, zero_ns, check);
+
+		sk_free(dst);
+		sk_free(src);
+		sk_msg_queue_delete(mq);
+	}
+}
+
+SHELL_CMD_EXPORT(test_mq_bench, test case of message queue copy against zero-copy throughput);
+
+#define BATCH_BENCH_LOOP 		1000
+#define BATCH_BENCH_N 			32
+#define BATCH_BENCH_MSG_SIZE 	16
+
+static sk_uint32_t batch_bench_rate(sk_uint64_t start, sk_uint64_t freq)
+{
+	/* messages per second */
+	return (sk_uint64_t)BATCH_BENCH_LOOP * BATCH_BENCH_N * freq / (lock_bench_counter() - start);
+}
+
+void test_batch_bench(void)
+{
+	static struct sk_mailbox mb;
+	static sk_ubase_t mb_pool[BATCH_BENCH_N];
+	static sk_ubase_t mails[BATCH_BENCH_N];
+	static sk_uint8_t msgs[BATCH_BENCH_N][BATCH_BENCH_MSG_SIZE];
+	struct sk_msg_queue *mq;
+	sk_uint64_t start, freq;
+	sk_uint32_t i, n;
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+	sk_mailbox_init(&mb, "batch_mb", mb_pool, BATCH_BENCH_N, SK_IPC_FLAG_FIFO);
+	mq = sk_msg_queue_create("batch_mq", BATCH_BENCH_MSG_SIZE, BATCH_BENCH_N, SK_IPC_FLAG_FIFO);
+	if(mq == SK_NULL)
+		return;
+
+	start = lock_bench_counter();
+	for(i = 0; i < BATCH_BENCH_LOOP; i++) {
+		for(n = 0; n < BATCH_BENCH_N; n++)
+			sk_mailbox_send(&mb, n);
+		for(n = 0; n < BATCH_BENCH_N; n++)
+			sk_mailbox_recv(&mb, &mails[n], 0);
+	}
+	sk_kprintf("mailbox send/recv: %d mails per second\n", batch_bench_rate(start, freq));
+
+	start = lock_bench_counter();
+	for(i = 0; i < BATCH_BENCH_LOOP; i++) {
+		sk_mailbox_send_n(&mb, mails, BATCH_BENCH_N, 0);
+		sk_mailbox_recv_n(&mb, mails, BATCH_BENCH_N, 0);
+	}
+	sk_kprintf("mailbox send_n/recv_n: %d mails per second\n", batch_bench_rate(start, freq));
+
+	start = lock_bench_counter();
+	for(i = 0; i < BATCH_BENCH_LOOP; i++) {
+		for(n = 0; n < BATCH_BENCH_N; n++)
+			sk_msg_queue_send(mq, msgs[n], BATCH_BENCH_MSG_SIZE);
+		for(n = 0; n < BATCH_BENCH_N; n++)
+			sk_msg_queue_recv(mq, msgs[n], BATCH_BENCH_MSG_SIZE, 0);
+	}
+	sk_kprintf("msg queue send/recv: %d messages per second\n", batch_bench_rate(start, freq));
+
+	start = lock_bench_counter();
+	for(i = 0; i < BATCH_BENCH_LOOP; i++) {
+		sk_msg_queue_send_n(mq, msgs, BATCH_BENCH_MSG_SIZE, BATCH_BENCH_N, 0);
+		sk_msg_queue_recv_n(mq, msgs, BATCH_BENCH_MSG_SIZE, BATCH_BENCH_N, 0);
+	}
+	sk_kprintf("msg queue send_n/recv_n: %d messages per second\n", batch_bench_rate(start, freq));
+
+	sk_msg_queue_delete(mq);
+}
+
+SHELL_CMD_EXPORT(test_batch_bench, test case of batched mailbox and message queue throughput);
+
+void test_mq_prio(void)
+{
+	struct sk_msg_queue *mq;
+	sk_uint8_t bands = 3;
+	sk_uint32_t msg, i;
+
+	mq = sk_msg_queue_create("mq_prio", sizeof(msg), 16, SK_IPC_FLAG_FIFO);
+	if(mq == SK_NULL)
+		return;
+	sk_msg_queue_control(mq, SK_MQ_CTRL_SET_BANDS, &bands);
+
+	/* bulk messages go to the last band */
+	for(i = 0; i < 6; i++) {
+		msg = 300 + i;
+		sk_msg_queue_send(mq, &msg, sizeof(msg));
+	}
+	for(i = 0; i < 2; i++) {
+		msg = 100 + i;
+		sk_msg_queue_send_prio(mq, &msg, sizeof(msg), 1, 0);
+	}
+	msg = 0;
+	sk_msg_queue_urgent(mq, &msg, sizeof(msg));
+
+	/* expect 0, 100, 101, 300 ... 305 */
+	while(sk_msg_queue_recv(mq, &msg, sizeof(msg), 0) == SK_EOK)
+		sk_kprintf("recv message %d\n", msg);
+
+	sk_msg_queue_delete(mq);
+}
+
+SHELL_CMD_EXPORT(test_mq_prio, test case of urgent and priority message queue);
@@ -0,0 +1,337 @@
+/*
+ *  test_irq.c
+ *  brief
+ *  	test case of interrupt handling
+ *
+ *  (C) 2025.04.15 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <skernel.h>
+#include <config.h>
+#include <hw.h>
+#include <sched.h>
+#include <workqueue.h>
+#include <shell.h>
+
+/* unused SPI of qemu virt machine, triggered by software */
+#define TEST_IRQ_VECTOR 		(VIRTIO_SPI_IRQ_BASE + 60)
+#define TEST_IRQ_STORM_COUNT 	10000
+
+static volatile sk_uint32_t irq_storm_count;
+static volatile sk_uint64_t irq_storm_pend;
+static sk_uint64_t irq_storm_latency_max;
+static sk_uint64_t irq_storm_latency_total;
+
+static inline sk_uint64_t test_irq_counter(void)
+{
+	sk_uint64_t cnt;
+
+	__asm__ volatile ("isb; mrs %0, CNTVCT_EL0" : "=r" (cnt));
+
+	return cnt;
+}
+
+static void test_irq_storm_isr(int vector, void *param)
+{
+	sk_uint64_t latency = test_irq_counter() - irq_storm_pend;
+
+	irq_storm_latency_total += latency;
+	if(latency > irq_storm_latency_max)
+		irq_storm_latency_max = latency;
+	irq_storm_count++;
+}
+
+/*
+ * software pended interrupts back to back, each one is taken as soon as it
+ * is pended. shows entry latency and the irq throughput of the entry path
+ */
+void test_irq_entry(void)
+{
+	sk_uint64_t start, cycles, freq;
+	sk_uint32_t i;
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+
+	irq_storm_count = 0;
+	irq_storm_latency_max = 0;
+	irq_storm_latency_total = 0;
+	sk_hw_interrupt_install(TEST_IRQ_VECTOR, test_irq_storm_isr, SK_NULL);
+	sk_hw_interrupt_umask(TEST_IRQ_VECTOR);
+
+	start = test_irq_counter();
+	for(i = 0; i < TEST_IRQ_STORM_COUNT; i++) {
+		irq_storm_pend = test_irq_counter();
+		sk_hw_interrupt_set_pending(TEST_IRQ_VECTOR);
+		while(irq_storm_count == i);
+	}
+	cycles = test_irq_counter() - start;
+
+	sk_hw_interrupt_mask(TEST_IRQ_VECTOR);
+
+#ifdef SK_USING_GICV3
+	sk_kprintf("gic: v3, system register cpu interface\n");
+#else
+	sk_kprintf("gic: v2, memory mapped cpu interface\n");
+#endif
+#ifdef SK_USING_IRQ_FAST_ENTRY
+	sk_kprintf("irq entry: caller-saved frame\n");
+#else
+	sk_kprintf("irq entry: full frame\n");
+#endif
+	sk_kprintf("%d irqs in %d cycles, %d irqs per second\n", TEST_IRQ_STORM_COUNT,
+			   (sk_uint32_t)cycles, (sk_uint32_t)(TEST_IRQ_STORM_COUNT * freq / cycles));
+	sk_kprintf("entry latency avg: %d cycles, max: %d cycles\n",
+			   (sk_uint32_t)(irq_storm_latency_total / TEST_IRQ_STORM_COUNT),
+			   (sk_uint32_t)irq_storm_latency_max);
+}
+
+SHELL_CMD_EXPORT(test_irq_entry, test case of irq entry latency and throughput);
+
+/* unused SPIs of qemu virt machine, fast one preempts the slow one */
+#define TEST_IRQ_FAST_VECTOR 	(VIRTIO_SPI_IRQ_BASE + 61)
+#define TEST_IRQ_SLOW_VECTOR 	(VIRTIO_SPI_IRQ_BASE + 62)
+#define TEST_IRQ_FAST_PRIORITY 	0x60
+#define TEST_IRQ_SLOW_PRIORITY 	0xc0
+#define TEST_IRQ_NEST_COUNT 	100
+
+static volatile sk_uint32_t irq_fast_count;
+static volatile sk_uint32_t irq_slow_count;
+static volatile sk_uint64_t irq_fast_pend;
+static sk_uint64_t irq_fast_latency_max;
+static sk_uint64_t irq_slow_busy;
+
+static void test_irq_fast_isr(int vector, void *param)
+{
+	sk_uint64_t latency = test_irq_counter() - irq_fast_pend;
+
+	if(latency > irq_fast_latency_max)
+		irq_fast_latency_max = latency;
+	irq_fast_count++;
+}
+
+/*
+ * slow handler pends the fast interrupt and then keeps the cpu busy, the
+ * fast handler runs inside it only if nesting works
+ */
+static void test_irq_slow_isr(int vector, void *param)
+{
+	sk_uint64_t start = test_irq_counter();
+
+	irq_fast_pend = start;
+	sk_hw_interrupt_set_pending(TEST_IRQ_FAST_VECTOR);
+	while(test_irq_counter() - start < irq_slow_busy);
+	irq_slow_count++;
+}
+
+void test_irq_nest(void)
+{
+	struct sk_cpu *cpu = sk_cpu_self();
+	sk_uint64_t freq;
+	sk_uint32_t i;
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+
+	/* slow handler runs 100us each time */
+	irq_slow_busy = freq / 10000;
+	irq_fast_count = 0;
+	irq_slow_count = 0;
+	irq_fast_latency_max = 0;
+	cpu->irq_nest_max = 0;
+
+	sk_hw_interrupt_install(TEST_IRQ_FAST_VECTOR, test_irq_fast_isr, SK_NULL);
+	sk_hw_interrupt_install(TEST_IRQ_SLOW_VECTOR, test_irq_slow_isr, SK_NULL);
+	sk_hw_interrupt_set_priority(TEST_IRQ_FAST_VECTOR, TEST_IRQ_FAST_PRIORITY);
+	sk_hw_interrupt_set_priority(TEST_IRQ_SLOW_VECTOR, TEST_IRQ_SLOW_PRIORITY);
+	sk_hw_interrupt_umask(TEST_IRQ_FAST_VECTOR);
+	sk_hw_interrupt_umask(TEST_IRQ_SLOW_VECTOR);
+
+	for(i = 0; i < TEST_IRQ_NEST_COUNT; i++) {
+		sk_hw_interrupt_set_pending(TEST_IRQ_SLOW_VECTOR);
+		while(irq_slow_count == i || irq_fast_count == i);
+	}
+
+	sk_hw_interrupt_mask(TEST_IRQ_FAST_VECTOR);
+	sk_hw_interrupt_mask(TEST_IRQ_SLOW_VECTOR);
+
+	sk_kprintf("fast irq latency max: %d cycles, slow isr: %d cycles\n",
+			   (sk_uint32_t)irq_fast_latency_max, (sk_uint32_t)irq_slow_busy);
+	sk_kprintf("irq nest max: %d\n", cpu->irq_nest_max);
+}
+
+SHELL_CMD_EXPORT(test_irq_nest, test case of nested interrupt latency);
+
+/* above the kernel threshold, never masked by kernel critical sections */
+#define TEST_IRQ_ZERO_LATENCY_PRIORITY 	0x20
+#define TEST_IRQ_MASK_COUNT 			100
+
+static volatile sk_uint32_t irq_mask_count;
+static volatile sk_uint64_t irq_mask_pend;
+static sk_uint64_t irq_mask_latency_max;
+
+static void test_irq_mask_isr(int vector, void *param)
+{
+	sk_uint64_t latency = test_irq_counter() - irq_mask_pend;
+
+	/* no kernel api here, it may run inside a kernel critical section */
+	if(latency > irq_mask_latency_max)
+		irq_mask_latency_max = latency;
+	irq_mask_count++;
+}
+
+/*
+ * pend the interrupt inside a 10us critical section, return the worst
+ * latency
+ */
+static sk_uint64_t test_irq_mask_run(sk_uint8_t priority, sk_bool_t kernel_mask)
+{
+	sk_uint64_t start, busy, freq;
+	sk_base_t level;
+	sk_uint32_t i;
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+	busy = freq / 100000;
+
+	irq_mask_count = 0;
+	irq_mask_latency_max = 0;
+	sk_hw_interrupt_set_priority(TEST_IRQ_VECTOR, priority);
+
+	for(i = 0; i < TEST_IRQ_MASK_COUNT; i++) {
+		if(kernel_mask)
+			level = hw_interrupt_mask_kernel();
+		else
+			level = hw_interrupt_disable();
+
+		start = test_irq_counter();
+		irq_mask_pend = start;
+		sk_hw_interrupt_set_pending(TEST_IRQ_VECTOR);
+		while(test_irq_counter() - start < busy);
+
+		if(kernel_mask)
+			hw_interrupt_unmask_kernel(level);
+		else
+			hw_interrupt_enable(level);
+
+		while(irq_mask_count == i);
+	}
+
+	return irq_mask_latency_max;
+}
+
+void test_irq_kernel_mask(void)
+{
+	sk_uint64_t latency;
+
+	sk_hw_interrupt_install(TEST_IRQ_VECTOR, test_irq_mask_isr, SK_NULL);
+	sk_hw_interrupt_umask(TEST_IRQ_VECTOR);
+
+	latency = test_irq_mask_run(TEST_IRQ_ZERO_LATENCY_PRIORITY, SK_TRUE);
+	sk_kprintf("priority mask, zero latency irq max: %d cycles\n", (sk_uint32_t)latency);
+	latency = test_irq_mask_run(SK_IRQ_PRIORITY_DEFAULT, SK_TRUE);
+	sk_kprintf("priority mask, kernel irq max: %d cycles\n", (sk_uint32_t)latency);
+	latency = test_irq_mask_run(TEST_IRQ_ZERO_LATENCY_PRIORITY, SK_FALSE);
+	sk_kprintf("daif mask, zero latency irq max: %d cycles\n", (sk_uint32_t)latency);
+
+	sk_hw_interrupt_mask(TEST_IRQ_VECTOR);
+	sk_hw_interrupt_set_priority(TEST_IRQ_VECTOR, SK_IRQ_PRIORITY_DEFAULT);
+}
+
+SHELL_CMD_EXPORT(test_irq_kernel_mask, test case of priority mask critical section);
+
+#define TEST_IRQ_THREADED_COUNT 	1000
+
+static volatile sk_uint32_t irq_thread_count;
+static sk_uint64_t irq_thread_latency_max;
+static sk_uint64_t irq_thread_latency_total;
+
+static void test_irq_thread_handler(int vector, void *param)
+{
+	sk_uint64_t latency = test_irq_counter() - irq_storm_pend;
+
+	irq_thread_latency_total += latency;
+	if(latency > irq_thread_latency_max)
+		irq_thread_latency_max = latency;
+	irq_thread_count++;
+}
+
+/*
+ * threaded handler, shows the delay from the interrupt to its bottom half
+ */
+void test_irq_threaded(void)
+{
+	struct sk_workqueue *wq = sk_workqueue_get(SK_WORK_PRIO_HIGH);
+	sk_uint32_t i, run;
+
+	irq_thread_count = 0;
+	irq_thread_latency_max = 0;
+	irq_thread_latency_total = 0;
+	run = wq->run_count;
+
+	if(sk_hw_interrupt_install_threaded(TEST_IRQ_VECTOR, test_irq_thread_handler,
+										SK_NULL, SK_WORK_PRIO_HIGH) != SK_EOK)
+		return;
+	sk_hw_interrupt_umask(TEST_IRQ_VECTOR);
+
+	for(i = 0; i < TEST_IRQ_THREADED_COUNT; i++) {
+		irq_storm_pend = test_irq_counter();
+		sk_hw_interrupt_set_pending(TEST_IRQ_VECTOR);
+		while(irq_thread_count == i);
+	}
+
+	sk_hw_interrupt_mask(TEST_IRQ_VECTOR);
+
+	sk_kprintf("%d threaded irqs, %d works run by %s\n", TEST_IRQ_THREADED_COUNT,
+			   wq->run_count - run, wq->thread.name);
+	sk_kprintf("bottom half latency avg: %d cycles, max: %d cycles\n",
+			   (sk_uint32_t)(irq_thread_latency_total / TEST_IRQ_THREADED_COUNT),
+			   (sk_uint32_t)irq_thread_latency_max);
+}
+
+SHELL_CMD_EXPORT(test_irq_threaded, test case of threaded interrupt handler);
+
+/* beyond the old fixed table of 96 vectors */
+#define TEST_IRQ_HIGH_VECTOR 		(VIRTIO_SPI_IRQ_BASE + 200)
+#define TEST_IRQ_SHARED_COUNT 		100
+
+static volatile sk_uint32_t irq_shared_count[2];
+
+static void test_irq_shared_isr(int vector, void *param)
+{
+	irq_shared_count[(sk_ubase_t)param]++;
+}
+
+void test_irq_shared(void)
+{
+	struct sk_irq_desc *desc;
+	sk_uint32_t i;
+
+	sk_kprintf("interrupt table size: %d\n", sk_hw_interrupt_max());
+
+	desc = sk_hw_interrupt_get_desc(TEST_IRQ_HIGH_VECTOR);
+	if(desc == SK_NULL) {
+		sk_kprintf("vector %d not supported\n", TEST_IRQ_HIGH_VECTOR);
+		return;
+	}
+
+	irq_shared_count[0] = 0;
+	irq_shared_count[1] = 0;
+	if(desc->handler == SK_NULL) {
+		sk_hw_interrupt_install_shared(TEST_IRQ_HIGH_VECTOR, test_irq_shared_isr, (void *)0);
+		sk_hw_interrupt_install_shared(TEST_IRQ_HIGH_VECTOR, test_irq_shared_isr, (void *)1);
+	}
+	sk_hw_interrupt_umask(TEST_IRQ_HIGH_VECTOR);
+
+	for(i = 0; i < TEST_IRQ_SHARED_COUNT; i++) {
+		sk_hw_interrupt_set_pending(TEST_IRQ_HIGH_VECTOR);
+		while(irq_shared_count[1] == i);
+	}
+
+	sk_hw_interrupt_mask(TEST_IRQ_HIGH_VECTOR);
+
+	sk_kprintf("vector %d taken %d times, handler 0: %d, handler 1: %d\n",
+			   TEST_IRQ_HIGH_VECTOR, desc->count, irq_shared_count[0], irq_shared_count[1]);
+}
+
+SHELL_CMD_EXPORT(test_irq_shared, test case of shared handlers beyond 96 vectors);
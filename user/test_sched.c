@@ -0,0 +1,211 @@
+/*
+ *  test_sched.c
+ *  brief
+ *  	test case of scheduler
+ *
+ *  (C) 2025.04.02 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <skernel.h>
+#include <timer.h>
+#include <sched.h>
+#include <shell.h>
+
+/*
+ * busy loop for the specified ticks of cpu time
+ */
+static void test_busy_tick(sk_tick_t tick)
+{
+	sk_tick_t last = sk_tick_get();
+
+	while(tick) {
+		if(sk_tick_get() != last) {
+			last = sk_tick_get();
+			tick--;
+		}
+	}
+}
+
+void edf_thread_entry(void *param)
+{
+	sk_tick_t work = (sk_tick_t)(sk_ubase_t)param;
+
+	for(sk_uint8_t i = 0; i < 50; i++) {
+		test_busy_tick(work);
+		sk_thread_edf_wait_period();
+	}
+	sk_kprintf("%s done, deadline miss: %d\n", sk_current_thread()->name,
+			   sk_current_thread()->edf.miss);
+}
+
+void test_edf(void)
+{
+	struct sk_thread *thread;
+
+	/* density 3/10 + 4/15 = 57% */
+	thread = sk_thread_edf_create("edf_thread_1", edf_thread_entry,
+								  (void *)2, 2048, 3, 10, 10);
+	if(thread)
+		sk_thread_startup(thread);
+	thread = sk_thread_edf_create("edf_thread_2", edf_thread_entry,
+								  (void *)3, 2048, 4, 15, 20);
+	if(thread)
+		sk_thread_startup(thread);
+
+	/* exceed the admission limit, must be rejected */
+	thread = sk_thread_edf_create("edf_thread_3", edf_thread_entry,
+								  (void *)1, 2048, 9, 10, 10);
+	if(thread == SK_NULL)
+		sk_kprintf("edf_thread_3 rejected by admission control\n");
+}
+
+SHELL_CMD_EXPORT(test_edf, test case of deadline scheduling);
+
+/* fair threads stop at this tick */
+static sk_tick_t fair_end_tick;
+
+void fair_thread_entry(void *param)
+{
+	while(SK_TICK_BEFORE(sk_tick_get(), fair_end_tick))
+		;
+	sk_kprintf("%s weight: %d, cpu ticks: %d\n", sk_current_thread()->name,
+			   sk_current_thread()->fair.weight,
+			   (sk_uint32_t)sk_current_thread()->fair.exec_tick);
+}
+
+void test_fair(void)
+{
+	struct sk_thread *thread;
+
+	/* cpu-bound threads, share of cpu should be 1:2:4 */
+	fair_end_tick = sk_tick_get() + 1400;
+	thread = sk_thread_fair_create("fair_thread_1", fair_thread_entry,
+								   SK_NULL, 2048, 512);
+	if(thread)
+		sk_thread_startup(thread);
+	thread = sk_thread_fair_create("fair_thread_2", fair_thread_entry,
+								   SK_NULL, 2048, 1024);
+	if(thread)
+		sk_thread_startup(thread);
+	thread = sk_thread_fair_create("fair_thread_3", fair_thread_entry,
+								   SK_NULL, 2048, 2048);
+	if(thread)
+		sk_thread_startup(thread);
+}
+
+SHELL_CMD_EXPORT(test_fair, test case of fair share scheduling);
+
+#define STORM_THREAD_NUM 		8
+#define STORM_LOOP 				200
+#define STORM_PERIOD 			5
+
+static volatile sk_uint32_t storm_done;
+
+void storm_thread_entry(void *param)
+{
+	for(sk_uint32_t i = 0; i < STORM_LOOP; i++) {
+		/* all threads wake up on the same tick */
+		sk_thread_sleep(STORM_PERIOD - sk_tick_get() % STORM_PERIOD);
+	}
+	storm_done++;
+}
+
+void test_timer_storm(void)
+{
+	struct sk_thread *thread;
+	struct sk_cpu *cpu = sk_cpu_self();
+	sk_uint32_t request, sched, sw;
+	sk_uint64_t isr_max, isr_total, total;
+	sk_tick_t tick;
+	char name[SK_NAME_MAX] = "storm_0";
+
+	request = cpu->resched_request;
+	sched = cpu->schedule_count;
+	sw = cpu->switch_count;
+	sk_tick_isr_time(&isr_max, &isr_total);
+	tick = sk_tick_get();
+
+	storm_done = 0;
+	for(sk_uint32_t i = 0; i < STORM_THREAD_NUM; i++) {
+		name[6] = '0' + i;
+		thread = sk_thread_create(name, storm_thread_entry, SK_NULL, 1024, 10, 10);
+		if(thread)
+			sk_thread_startup(thread);
+	}
+
+	while(storm_done != STORM_THREAD_NUM)
+		sk_thread_delay(100);
+
+	tick = sk_tick_get() - tick;
+	sk_tick_isr_time(&isr_max, &total);
+	total -= isr_total;
+
+	sk_kprintf("%d wakeups in %d ticks\n", STORM_THREAD_NUM * STORM_LOOP, tick);
+	sk_kprintf("reschedule requests: %d\n", cpu->resched_request - request);
+	sk_kprintf("scheduler runs: %d\n", cpu->schedule_count - sched);
+	sk_kprintf("context switches: %d\n", cpu->switch_count - sw);
+	sk_kprintf("tick isr cycles max: %d, avg: %d\n", (sk_uint32_t)isr_max,
+			   (sk_uint32_t)(total / tick));
+}
+
+SHELL_CMD_EXPORT(test_timer_storm, test case of reschedule under timer storm);
+
+void test_irq_latency(void)
+{
+	sk_uint64_t latency, freq;
+	sk_tick_t end, tick = 10;
+	struct sk_thread *thread = sk_current_thread();
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+
+	/* kernel list walks and timer reconfiguration under the tick */
+	sk_tick_isr_latency(SK_TRUE);
+	end = sk_tick_get() + 1000;
+	while(SK_TICK_BEFORE(sk_tick_get(), end)) {
+		sk_object_find("no_such_thread", SK_OBJECT_THREAD);
+		sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_GET_TIME, &tick);
+		sk_timer_control(&(thread->thread_timer), SK_TIMER_CTRL_SET_TIME, &tick);
+	}
+	latency = sk_tick_isr_latency(SK_FALSE);
+
+	sk_kprintf("tick isr latency max: %d cycles, %d ns\n", (sk_uint32_t)latency,
+			   (sk_uint32_t)(latency * 1000000000 / freq));
+}
+
+SHELL_CMD_EXPORT(test_irq_latency, test case of worst interrupt latency);
+
+void affinity_thread_entry(void *param)
+{
+	sk_uint32_t mask = SK_CPU_MASK_SCHED;
+
+	/* pin itself to the cpus that schedule threads */
+	sk_thread_control(sk_current_thread(), SK_THREAD_CTRL_BIND_CPU, &mask);
+	sk_kprintf("%s runs on cpu %d, allowed mask 0x%x\n", sk_current_thread()->name,
+			   sk_current_thread()->oncpu, sk_current_thread()->cpus_allowed);
+}
+
+void test_affinity(void)
+{
+	struct sk_thread *thread;
+	sk_uint32_t mask = 0;
+
+	thread = sk_thread_create("affinity", affinity_thread_entry, SK_NULL, 1024, 10, 10);
+	if(thread == SK_NULL)
+		return;
+
+	/* no cpu left, must be rejected */
+	if(sk_thread_control(thread, SK_THREAD_CTRL_BIND_CPU, &mask) == SK_EINVAL)
+		sk_kprintf("empty affinity mask rejected\n");
+
+	/* only cpus serving ipis, the thread could never run */
+	mask = SK_CPU_MASK_ALL & ~SK_CPU_MASK_SCHED;
+	if(sk_thread_control(thread, SK_THREAD_CTRL_BIND_CPU, &mask) == SK_EINVAL)
+		sk_kprintf("affinity mask without scheduling cpu rejected\n");
+
+	sk_thread_startup(thread);
+}
+
+SHELL_CMD_EXPORT(test_affinity, test case of thread cpu affinity);
@@ -0,0 +1,133 @@
+/*
+ *  test_smp.c
+ *  brief
+ *  	test case of inter-processor interrupts
+ *
+ *  (C) 2025.04.26 <hkdywg@163.com>
+ *
+ *  This program is free software; you can redistribute it and/r modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ * */
+#include <skernel.h>
+#include <sched.h>
+#include <hw.h>
+#include <shell.h>
+#include <atomic.h>
+#include <spinlock.h>
+
+#define IPI_LOOP 			1000
+
+static void ipi_noop(void *param)
+{
+}
+
+static void ipi_where(void *param)
+{
+	*(volatile sk_uint32_t *)param = hw_cpu_id();
+}
+
+static void ipi_count(void *param)
+{
+	sk_atomic_fetch_add32((sk_uint32_t *)param, 1);
+}
+
+void test_ipi(void)
+{
+	sk_uint64_t freq, start, end, cycles, total = 0;
+	sk_uint32_t min = 0xffffffff, max = 0;
+	sk_uint32_t where = 0xff, count = 0, resched;
+
+	if(!(sk_cpu_online_mask() & (1U << 1))) {
+		sk_kprintf("cpu 1 is offline, set SK_CPUS_NR 2 and run with CORE_NUM=2\n");
+		return;
+	}
+
+	__asm__ volatile ("mrs %0, CNTFRQ_EL0" : "=r" (freq));
+
+	sk_smp_call(1, ipi_where, &where, SK_TRUE);
+	sk_kprintf("call ran on cpu %d\n", where);
+
+	/* round trip: send, run on cpu 1, see the completion */
+	for(sk_uint32_t i = 0; i < IPI_LOOP; i++) {
+		__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (start));
+		sk_smp_call(1, ipi_noop, SK_NULL, SK_TRUE);
+		__asm__ volatile ("mrs %0, CNTVCT_EL0" : "=r" (end));
+		cycles = end - start;
+		total += cycles;
+		if(cycles < min)
+			min = cycles;
+		if(cycles > max)
+			max = cycles;
+	}
+	sk_kprintf("ipi round trip cycles min: %d, avg: %d, max: %d\n", min,
+			   (sk_uint32_t)(total / IPI_LOOP), max);
+	sk_kprintf("ipi round trip avg: %d ns\n",
+			   (sk_uint32_t)(total / IPI_LOOP * 1000000000 / freq));
+
+	sk_smp_call_others(ipi_count, &count, SK_TRUE);
+	sk_kprintf("broadcast reached %d cpus\n", count);
+
+	resched = sk_smp_ipi_count(1, SK_IPI_RESCHEDULE);
+	sk_smp_send_reschedule(1);
+	sk_thread_delay(1);
+	sk_kprintf("reschedule ipis taken by cpu 1: %d\n",
+			   sk_smp_ipi_count(1, SK_IPI_RESCHEDULE) - resched);
+}
+
+SHELL_CMD_EXPORT(test_ipi, test case of inter-processor interrupt round trip);
+
+#define SPIN_LOOP 			100000
+
+static sk_spinlock_t spin_test_lock;
+static sk_uint32_t spin_counter;
+static volatile sk_uint32_t spin_done;
+
+static void spin_worker(void *param)
+{
+	for(sk_uint32_t i = 0; i < SPIN_LOOP; i++) {
+		sk_spin_lock(&spin_test_lock);
+		spin_counter++;
+		sk_spin_unlock(&spin_test_lock);
+	}
+	spin_done = 1;
+}
+
+void test_spinlock(void)
+{
+	static sk_bool_t spin_test_init = SK_FALSE;
+
+	sk_kprintf("lse atomics: %s\n", sk_atomic_lse ? "yes" : "no");
+
+	if(!(sk_cpu_online_mask() & (1U << 1))) {
+		sk_kprintf("cpu 1 is offline, set SK_CPUS_NR 2 and run with CORE_NUM=2\n");
+		return;
+	}
+
+	/* a lock is initialized once, it stays on the statistics list */
+	if(!spin_test_init) {
+		sk_spin_lock_init(&spin_test_lock, "spin_test");
+		spin_test_init = SK_TRUE;
+	}
+	spin_counter = 0;
+	spin_done = 0;
+
+	/* both cpus increase the counter under the lock at the same time */
+	sk_smp_call(1, spin_worker, SK_NULL, SK_FALSE);
+	for(sk_uint32_t i = 0; i < SPIN_LOOP; i++) {
+		sk_spin_lock(&spin_test_lock);
+		spin_counter++;
+		sk_spin_unlock(&spin_test_lock);
+	}
+	while(!spin_done)
+		;
+
+	sk_kprintf("counter: %d, expected: %d\n", spin_counter, 2 * SPIN_LOOP);
+#ifdef SK_USING_SPINLOCK_STAT
+	sk_kprintf("acquired: %d, contended: %d, spin max: %d cycles\n",
+			   spin_test_lock.acquire_count, spin_test_lock.contend_count,
+			   (sk_uint32_t)spin_test_lock.spin_max);
+#endif
+}
+
+SHELL_CMD_EXPORT(test_spinlock, test case of ticket spinlock between two cpus);